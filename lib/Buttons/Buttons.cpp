@@ -0,0 +1,207 @@
+//
+// Interrupt driven push buttons: debouncing and press, hold and repeat events.
+//
+
+#include "Buttons.h"
+
+Buttons::Buttons() {
+    count = 0;
+    head = 0;
+    tail = 0;
+    overflow = false;
+    captured = 0;
+    recheck = 0;
+    eventHead = 0;
+    eventCount = 0;
+}
+
+uint8_t Buttons::add(uint8_t pin, bool activeLow, bool repeats) {
+    if(count == BUTTONS_MAX)
+        return BUTTON_NONE;
+    Button& button = buttons[count];
+    button.pin = pin;
+    button.activeLow = activeLow;
+    button.repeats = repeats;
+    button.down = false;
+    button.held = false;
+    button.ignored = false;
+    button.changed = 0;
+    button.repeatTime = 0;
+    return count++;
+}
+
+/**
+ * @details A button down at start is taken as already used: it sends nothing until it was released.
+ */
+void Buttons::begin() {
+    uint8_t levels = readLevels();
+    captured = levels;
+    uint32_t now = millis();
+    for(uint8_t i = 0; i < count; i++){
+        buttons[i].down = levels >> i & 1;
+        buttons[i].ignored = buttons[i].down;
+        buttons[i].changed = now;
+#ifdef digitalPinToPCICR
+        // the AVR cores define where the pin change interrupt of each pin is enabled
+        volatile uint8_t* control = digitalPinToPCICR(buttons[i].pin);
+        if(control){
+            *control |= _BV(digitalPinToPCICRbit(buttons[i].pin));
+            *digitalPinToPCMSK(buttons[i].pin) |= _BV(digitalPinToPCMSKbit(buttons[i].pin));
+        }
+#endif
+    }
+}
+
+uint8_t Buttons::readLevels() const {
+    uint8_t levels = 0;
+    for(uint8_t i = 0; i < count; i++)
+        if((digitalRead(buttons[i].pin) == LOW) == buttons[i].activeLow)
+            levels |= 1 << i;
+    return levels;
+}
+
+/**
+ * @details Runs in the interrupt handler. A pin change interrupt also fires for pins of the same port that are no
+ * buttons, so only a change of the button levels is queued. When the queue is full the sample is dropped and next()
+ * reads the pins itself.
+ */
+bool Buttons::capture() {
+    uint8_t levels = readLevels();
+    if(levels == captured)
+        return false;
+    captured = levels;
+    uint8_t next = (head + 1) % BUTTONS_QUEUE;
+    if(next == tail){
+        overflow = true;
+        return true;
+    }
+    samples[head].time = millis();
+    samples[head].levels = levels;
+    head = next; // published last: next() only reads a complete sample
+    return true;
+}
+
+void Buttons::push(uint8_t button, ButtonEventType type) {
+    if(eventCount == BUTTONS_QUEUE)
+        return; // next() is not called often enough; the oldest events are kept
+    events[(eventHead + eventCount) % BUTTONS_QUEUE] = {button, type};
+    eventCount++;
+}
+
+void Buttons::change(uint8_t index, uint32_t time, bool down) {
+    Button& button = buttons[index];
+    button.down = down;
+    button.changed = time;
+    recheck |= 1 << index;
+    if(down){
+        button.held = false;
+        button.ignored = false;
+        button.repeatTime = time + BUTTON_REPEAT_MS;
+        push(index, BUTTON_PRESSED);
+    }
+    else{
+        push(index, BUTTON_RELEASED);
+        if(!button.held && !button.ignored)
+            push(index, BUTTON_CLICKED);
+    }
+}
+
+void Buttons::apply(uint32_t time, uint8_t levels) {
+    for(uint8_t i = 0; i < count; i++){
+        bool down = levels >> i & 1;
+        // no change, or a bounce: the level is read again when the debounce time is over
+        if(down != buttons[i].down && (int32_t)(time - buttons[i].changed) >= BUTTON_DEBOUNCE_MS)
+            change(i, time, down);
+    }
+}
+
+void Buttons::checkTimers(uint32_t now) {
+    if(recheck){
+        uint8_t levels = readLevels();
+        for(uint8_t i = 0; i < count; i++){
+            if(!(recheck >> i & 1) || now - buttons[i].changed < BUTTON_DEBOUNCE_MS)
+                continue;
+            recheck &= ~(1 << i);
+            bool down = levels >> i & 1; // the level the bounces settled on
+            if(down != buttons[i].down)
+                change(i, now, down);
+        }
+    }
+    for(uint8_t i = 0; i < count; i++){
+        Button& button = buttons[i];
+        if(!button.down || button.ignored)
+            continue;
+        if(!button.held && now - button.changed >= BUTTON_HOLD_MS){
+            button.held = true;
+            push(i, BUTTON_HELD);
+        }
+        if(button.repeats && (int32_t)(now - button.repeatTime) >= 0){
+            button.repeatTime += BUTTON_REPEAT_MS;
+            if((int32_t)(now - button.repeatTime) >= 0)
+                button.repeatTime = now + BUTTON_REPEAT_MS; // next() was late, no burst
+            push(i, BUTTON_REPEATED);
+        }
+    }
+}
+
+/**
+ * @details The samples are applied in the order they were captured, with the time of their interrupt, so a press
+ * and release that both happened since the last call are both seen.
+ */
+bool Buttons::next(ButtonEvent& event) {
+    while(tail != head){
+        apply(samples[tail].time, samples[tail].levels);
+        tail = (tail + 1) % BUTTONS_QUEUE;
+    }
+    if(overflow){
+        overflow = false;
+        apply(millis(), readLevels());
+    }
+    checkTimers(millis());
+    if(eventCount == 0)
+        return false;
+    event = events[eventHead];
+    eventHead = (eventHead + 1) % BUTTONS_QUEUE;
+    eventCount--;
+    return true;
+}
+
+uint32_t Buttons::nextDeadline() {
+    if(eventCount || tail != head)
+        return 0;
+    uint32_t now = millis();
+    uint32_t wait = BUTTONS_NO_DEADLINE;
+    for(uint8_t i = 0; i < count; i++){
+        const Button& button = buttons[i];
+        uint32_t deadlines[3];
+        uint8_t n = 0;
+        if(recheck >> i & 1)
+            deadlines[n++] = button.changed + BUTTON_DEBOUNCE_MS;
+        if(button.down && !button.ignored && !button.held)
+            deadlines[n++] = button.changed + BUTTON_HOLD_MS;
+        if(button.down && !button.ignored && button.repeats)
+            deadlines[n++] = button.repeatTime;
+        while(n--){
+            int32_t remaining = (int32_t)(deadlines[n] - now);
+            if(remaining <= 0)
+                return 0;
+            if((uint32_t)remaining < wait)
+                wait = remaining;
+        }
+    }
+    return wait;
+}
+
+bool Buttons::pending() const {
+    return tail != head || overflow;
+}
+
+void Buttons::ignoreHeld() {
+    for(uint8_t i = 0; i < count; i++)
+        if(buttons[i].down)
+            buttons[i].ignored = true;
+}
+
+bool Buttons::isDown(uint8_t button) const {
+    return button < count && buttons[button].down;
+}
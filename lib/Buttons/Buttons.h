@@ -0,0 +1,129 @@
+//
+// Interrupt driven push buttons: debouncing and press, hold and repeat events.
+//
+
+#ifndef DS3231_RTC_BUTTONS_H
+#define DS3231_RTC_BUTTONS_H
+
+#include <Arduino.h>
+
+/// buttons a Buttons object can watch
+#define BUTTONS_MAX 8
+/// pin samples that can wait between two calls of next(), a power of two
+#define BUTTONS_QUEUE 8
+/// returned by add() when the table is full, by nextDeadline() when nothing is timed
+#define BUTTON_NONE 0xFF
+#define BUTTONS_NO_DEADLINE 0xFFFFFFFFUL
+
+/// a change of level sooner than this after the last accepted one is a bounce
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 20
+#endif
+/// a button held down this long sends BUTTON_HELD, and no BUTTON_CLICKED when released
+#ifndef BUTTON_HOLD_MS
+#define BUTTON_HOLD_MS 700
+#endif
+/// period of BUTTON_REPEATED while a repeating button is held down
+#ifndef BUTTON_REPEAT_MS
+#define BUTTON_REPEAT_MS 200
+#endif
+
+enum ButtonEventType : uint8_t{
+    BUTTON_PRESSED, // went down
+    BUTTON_RELEASED, // went up
+    BUTTON_CLICKED, // went up before BUTTON_HOLD_MS, sent after BUTTON_RELEASED
+    BUTTON_HELD, // down for BUTTON_HOLD_MS
+    BUTTON_REPEATED // every BUTTON_REPEAT_MS after BUTTON_PRESSED while down, if the button repeats
+};
+
+struct ButtonEvent{
+    /// the index returned by Buttons::add()
+    uint8_t button;
+    ButtonEventType type;
+};
+
+/**
+ * @brief Watches push buttons through pin change interrupts.
+ *
+ * The interrupt handler only calls capture(), which stores the levels of the buttons and the time in a queue
+ * written by the interrupt and read by next() (one producer, one consumer: no lock). next() debounces and classifies
+ * in the main program: the first edge is taken at once and the edges that follow it within BUTTON_DEBOUNCE_MS are
+ * bounces; the level is checked again when that time is over. Hold and repeat are timed by next() too, so it must be
+ * called again after nextDeadline() milliseconds while a button is down.
+ *
+ * The sketch defines the pin change interrupt handlers (ISR(PCINTn_vect) calling capture()); begin() enables the
+ * pin change interrupt of every button pin.
+ */
+class Buttons{
+private:
+    struct Sample{
+        uint32_t time;
+        uint8_t levels; // bit per button, 1 -> down
+    };
+    struct Button{
+        uint8_t pin;
+        bool activeLow;
+        bool repeats;
+        bool down; // debounced state
+        bool held; // BUTTON_HELD was sent for this press
+        bool ignored; // this press sends nothing more
+        uint32_t changed; // millis() of the last accepted change
+        uint32_t repeatTime; // millis() of the next BUTTON_REPEATED
+    };
+
+    Button buttons[BUTTONS_MAX];
+    uint8_t count;
+    /// pin samples: written by capture() at head, read by next() at tail
+    Sample samples[BUTTONS_QUEUE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    volatile bool overflow;
+    /// levels of the last sample queued
+    uint8_t captured;
+    /// buttons whose level has to be read again when their debounce time is over
+    uint8_t recheck;
+    /// events classified but not yet returned by next()
+    ButtonEvent events[BUTTONS_QUEUE];
+    uint8_t eventHead;
+    uint8_t eventCount;
+
+    uint8_t readLevels() const;
+    void push(uint8_t button, ButtonEventType type);
+    void change(uint8_t index, uint32_t time, bool down);
+    void apply(uint32_t time, uint8_t levels);
+    void checkTimers(uint32_t now);
+
+public:
+    Buttons();
+    /**
+     * Adds a button; call it before begin().
+     * @param pin The pin, already set up with pinMode()
+     * @param activeLow True if the pin reads LOW while the button is down
+     * @param repeats True to send BUTTON_REPEATED while the button is held down
+     * @return The index of the button in its events, BUTTON_NONE if the table is full
+     */
+    uint8_t add(uint8_t pin, bool activeLow, bool repeats);
+    /// Reads the levels of the buttons and enables their pin change interrupts.
+    void begin();
+    /**
+     * Queues the levels of the buttons if they changed. Called by the pin change interrupt handlers.
+     * @return False if no button changed: the interrupt came from another pin of the port
+     */
+    bool capture();
+    /**
+     * Takes the next button event.
+     * @param event Receives the event
+     * @return False if there is none
+     */
+    bool next(ButtonEvent& event);
+    /// Milliseconds until next() has a timed event to send or a level to check; BUTTONS_NO_DEADLINE if none.
+    uint32_t nextDeadline();
+    /// True if capture() queued levels that next() has not read.
+    bool pending() const;
+    /// The buttons down now were used for something else: their release, hold and repeat send nothing.
+    void ignoreHeld();
+    /// True if the button is down (debounced).
+    bool isDown(uint8_t button) const;
+};
+
+#endif //DS3231_RTC_BUTTONS_H
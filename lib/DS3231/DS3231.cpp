@@ -8,18 +8,49 @@
 DS3231::DS3231(bool INTCtr) {
     // sets the INT bit
     this->INTCtr = INTCtr;
-    clockTime.seconds = 0;
-    clockTime.minutes = 0;
-    clockTime.hour = 0;
-    clockTime.day = FRIDAY;
-    clockTime.date = 1;
-    clockTime.month = JANUARY;
-    clockTime.year = 2021;
+    clockTime = RTCdata::make(2021, JANUARY, 1, 0, 0, 0);
     // alarms are disabled at start
     // A1IE & A2IE bits are set low in the begin method
     alarm1.enabled = false;
     alarm2.enabled = false;
     timeKeep = 0; // always restarts temperature sampling
+    hourHead = 0;
+    dayHead = 0;
+    weekHead = 0;
+    for(uint8_t tier = TIER_MINUTE; tier <= TIER_WEEK; tier++)
+        stored[tier] = 0;
+    DS3231::clearAccumulator(currentHour);
+    DS3231::clearAccumulator(currentDay);
+    DS3231::clearAccumulator(currentWeek);
+    shadowValid = 0; // control and status registers are read on first use
+    softClock = false;
+    pendingTicks = 0;
+    resyncMinutes = 0;
+    minutesSinceSync = 0;
+    resyncRequested = false;
+    softAlarmFlags = 0;
+    lastSample = 0;
+    jobHead = 0;
+    jobCount = 0;
+    dataHead = 0;
+    dataCount = 0;
+    eepromBusy = false;
+    eepromBusySince = 0;
+    eepromAttempts = 0;
+    eepromCallback = nullptr;
+    alarmTableCount = 0;
+    resetBusCounters();
+    busRetries = BUS_RETRIES;
+    busBackoff = BUS_BACKOFF_MICROS;
+    lastBusStatus = BUS_OK;
+#if DS3231_STATS
+    resetStats();
+    statsDepth = 0;
+#endif
+    for(uint8_t i = 0; i < 3; i++){
+        logHead[i] = TEMP_LOG_NONE;
+        logSeq[i] = 0;
+    }
 }
 
 /**
@@ -28,7 +59,8 @@ DS3231::DS3231(bool INTCtr) {
  */
 //initialize the DS3231 RTC
 void DS3231::begin(){
-    Wire.begin(); // initializes the library
+    DS3231_STAT(STAT_BEGIN);
+    Bus::begin(); // initializes the bus
     DS3231::writeINTCtr(true); // enables INTCN bit from Control register
     // sets the alarm interrupts and disables any alarm flags
     snoozeAlarm();
@@ -47,43 +79,102 @@ void DS3231::begin(){
     toggleAlarm(2,alarm2.enabled);
     takeStoredTemperature(); // take last temperatures from memory
     readTime();
+    takeAlarmTable(); // after the time: the next time of every alarm is computed from it
 }
 
+// one row of the encode table: 0x<tens>0 ... 0x<tens>9
+#define BCD_ROW(tens) 0x##tens##0, 0x##tens##1, 0x##tens##2, 0x##tens##3, 0x##tens##4, \
+                      0x##tens##5, 0x##tens##6, 0x##tens##7, 0x##tens##8, 0x##tens##9
+
+// binary (0 - 99) to BCD; the AVR has no divider, so a flash lookup replaces the / 10 and % 10
+static const uint8_t DEC_TO_BCD[100] PROGMEM = {
+        BCD_ROW(0), BCD_ROW(1), BCD_ROW(2), BCD_ROW(3), BCD_ROW(4),
+        BCD_ROW(5), BCD_ROW(6), BCD_ROW(7), BCD_ROW(8), BCD_ROW(9)
+};
+
 // converts binary coded decimal to decimal
+// tens * 16 + units - 6 * tens = tens * 10 + units: one multiply, no branch
 uint8_t DS3231::BCDtoDEC(const uint8_t code) {
-    uint8_t digit1, digit2;
-    digit1 = (code & 0xF0) >> 4;
-    digit2 = (code & 0x0F);
-    return (digit1 * 10 + digit2);
+    return code - 6 * (code >> 4);
 }
 
-// converts decimal to binary
+// converts decimal to binary coded decimal (values above 99 are clamped)
 uint8_t DS3231::DECtoBCD(const uint8_t dec) {
-    uint8_t code, digit1, digit2;
-    digit1 = ((dec / 10) << 4) | 0x0F;
-    digit2 = (dec % 10) | 0xF0;
-    code = digit1 & digit2;
-    return code;
+    return pgm_read_byte(&DEC_TO_BCD[dec < 100 ? dec : 99]);
 }
 
 /**
  * @details This method is private because it is used by other methods (mainly the alarm methods).
  */
 void DS3231::writeINTCtr(bool enable) {
-    //reads from control register
-    uint8_t byte[1];
-    DS3231::readRegister(REG_CONTROL,byte,1);
+    uint8_t control = DS3231::readControl();
     //modifies the INTCN bit
-    if(enable){
-        byte[0] = DS3231::setHigh(byte[0],2);
-        INTCtr = true;
+    if(enable)
+        control = DS3231::setHigh(control, BIT_INTCN);
+    else
+        control = DS3231::setLow(control, BIT_INTCN);
+    INTCtr = enable;
+    DS3231::writeControl(control);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                      CONTROL & STATUS REGISTER SHADOWS
+---------------------------------------------------------------------------------------------------------------------*/
+
+/**
+ * @details The control register is only changed by the library (CONV is never used), so once it has been
+ * read the RAM copy stays coherent and every read-modify-write becomes a single write.
+ */
+uint8_t DS3231::readControl() {
+    if(!(shadowValid & 0x01)){
+        uint8_t byte[1];
+        if(DS3231::readRegister(REG_CONTROL, byte, 1) != BUS_OK)
+            return controlShadow; // stays invalid, read again next time
+        controlShadow = byte[0];
+        shadowValid |= 0x01;
     }
-    else{
-        byte[0] = DS3231::setLow(byte[0],2);
-        INTCtr = false;
+    return controlShadow;
+}
+
+void DS3231::writeControl(uint8_t value) {
+    if((shadowValid & 0x01) && controlShadow == value)
+        return; // nothing changes
+    uint8_t byte[1] = {value};
+    if(DS3231::writeRegister(REG_CONTROL, byte, 1) != BUS_OK){
+        shadowValid &= ~0x01; // the register content is unknown
+        return;
+    }
+    controlShadow = value;
+    shadowValid |= 0x01;
+}
+
+/**
+ * @details A1F, A2F, OSF and BSY are changed by the device itself, so they are masked out of the shadow copy.
+ * Only EN32kHz is kept; it is enough to write the status register without reading it first.
+ */
+uint8_t DS3231::readStatus() {
+    if(!(shadowValid & 0x02)){
+        uint8_t byte[1];
+        if(DS3231::readRegister(REG_STATUS, byte, 1) != BUS_OK)
+            return statusShadow;
+        statusShadow = byte[0] & ~STATUS_VOLATILE;
+        shadowValid |= 0x02;
+    }
+    return statusShadow;
+}
+
+void DS3231::writeStatus(uint8_t value) {
+    uint8_t byte[1] = {value};
+    if(DS3231::writeRegister(REG_STATUS, byte, 1) != BUS_OK){
+        shadowValid &= ~0x02;
+        return;
     }
-    //writes to control register
-    DS3231::writeRegister(REG_CONTROL,byte,1);
+    statusShadow = value & ~STATUS_VOLATILE;
+    shadowValid |= 0x02;
+}
+
+void DS3231::invalidateRegisterCache() {
+    shadowValid = 0;
 }
 
 /*--------------------------------------------------------------------------------------------------------------------
@@ -91,20 +182,20 @@ void DS3231::writeINTCtr(bool enable) {
 ---------------------------------------------------------------------------------------------------------------------*/
 
 /**
- * @details This method uses the Wire library to communicate with the device via I2C and read
- * the desired register of the device.
+ * @details This method uses the bus transport to communicate with the device via I2C and read
+ * the desired register of the device. The register pointer is written again on every attempt.
  */
-void DS3231::readRegister(const uint8_t reg, uint8_t byteBuffer[], const uint16_t bytes) {
-    Wire.beginTransmission(DS3231_ADDRESS);
-    Wire.write(reg);// specifies what register to read from
-    uint8_t check = Wire.endTransmission(false);
-    if(check == 0){
-        uint8_t length = Wire.requestFrom((int)DS3231_ADDRESS, (int)bytes, (int)true); // requests the content of the register
-        if(length == bytes){
-            for(uint8_t i=0; i<bytes; i++)
-                byteBuffer[i] = Wire.read();
-        }
-    }
+BusStatus DS3231::readRegister(const uint8_t reg, uint8_t byteBuffer[], const uint16_t bytes) {
+    BusStatus status;
+    uint8_t attempt = 0;
+    do{
+        Bus::beginWrite(DS3231_ADDRESS);
+        Bus::write(reg);// specifies what register to read from
+        status = BusStatus(Bus::endWrite(false));
+        if(status == BUS_OK && Bus::read(DS3231_ADDRESS, byteBuffer, bytes) != bytes) // requests the content of the register
+            status = BUS_SHORT_READ;
+    } while(retry(rtcCounters, status, attempt++));
+    return status;
 }
 
 /*--------------------------------------------------------------------------------------------------------------------
@@ -112,79 +203,315 @@ void DS3231::readRegister(const uint8_t reg, uint8_t byteBuffer[], const uint16_
 ---------------------------------------------------------------------------------------------------------------------*/
 
 /**
- * @details This method uses the Wire library to communicate with the device via I2C and write
+ * @details This method uses the bus transport to communicate with the device via I2C and write
  * information to the specified register.
  */
-void DS3231::writeRegister(const uint8_t reg, const uint8_t* value, const uint8_t bytes) {
-    Wire.beginTransmission(DS3231_ADDRESS);
-    Wire.write(reg); // specifies what register to write to
-    //Wire.write(value); // sends the byte to that register
-    for(uint8_t i = 0; i<bytes; i++){
-        Wire.write(value[i]);
+BusStatus DS3231::writeRegister(const uint8_t reg, const uint8_t* value, const uint8_t bytes) {
+    BusStatus status;
+    uint8_t attempt = 0;
+    do{
+        Bus::beginWrite(DS3231_ADDRESS);
+        Bus::write(reg); // specifies what register to write to
+        for(uint8_t i = 0; i<bytes; i++){
+            Bus::write(value[i]);
+        }
+        status = BusStatus(Bus::endWrite(true));
+    } while(retry(rtcCounters, status, attempt++));
+    return status;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                          BUS ERRORS AND RETRIES
+---------------------------------------------------------------------------------------------------------------------*/
+
+/**
+ * @details The backoff doubles with every attempt; waits of a millisecond or more use delay(), which stays
+ * accurate where delayMicroseconds() does not.
+ */
+bool DS3231::retry(BusCounters& counters, BusStatus status, uint8_t attempt) {
+    lastBusStatus = status;
+    if(status == BUS_OK)
+        return false;
+    DS3231::countFailure(counters, status);
+    if(attempt >= busRetries){
+        counters.failures++;
+        return false;
     }
-    Wire.endTransmission(true);
+    counters.retries++;
+    uint32_t wait = (uint32_t)busBackoff << min(attempt, (uint8_t)15);
+    if(wait >= 1000)
+        delay(wait / 1000);
+    else
+        delayMicroseconds(wait);
+    return true;
 }
 
+void DS3231::countFailure(BusCounters& counters, BusStatus status) {
+    if(status == BUS_SHORT_READ)
+        counters.shortReads++;
+    else if(status == BUS_NACK_ADDRESS || status == BUS_NACK_DATA)
+        counters.nacks++;
+}
+
+void DS3231::setRetryPolicy(uint8_t retries, uint16_t backoffMicros) {
+    busRetries = retries;
+    busBackoff = backoffMicros;
+}
+
+const BusCounters& DS3231::busCounters(uint8_t address) const {
+    return address == EEPROM_ADDRESS ? eepromCounters : rtcCounters;
+}
+
+void DS3231::resetBusCounters() {
+    rtcCounters = BusCounters{0, 0, 0, 0};
+    eepromCounters = BusCounters{0, 0, 0, 0};
+}
+
+BusStatus DS3231::busStatus() const {
+    return lastBusStatus;
+}
+
+#if DS3231_STATS
 /*--------------------------------------------------------------------------------------------------------------------
- *                                           Interact with the EEPROM
+ *                                           BUS INSTRUMENTATION
 ---------------------------------------------------------------------------------------------------------------------*/
 
-void DS3231::writeEEPROM(uint16_t address, uint8_t byteBuffer[], const uint16_t bytes){
-    int remainingBytes = bytes;   // bytes left to write
-    int offsetDataBuffer = 0;           // current offset in dataBuffer pointer
-    int offsetPage;                     // current offset in page
-    int nextByte = 0;                   // next n bytes to write
-    int pageSize = 32;
+static const char STAT_NAMES[STAT_COUNT][16] PROGMEM = {
+        "begin", "hourMode", "setTime", "setDate", "readTime", "readSnapshot", "softTime", "softClock",
+        "checkAlarmFlag", "setAlarm", "toggleAlarm", "snoozeAlarm", "alarmEEPROM", "alarmTable", "temperature", "outputs",
+        "poll"
+};
 
-    // write all bytes in multiple steps
-    while (remainingBytes > 0) {
-        // calc offset in page
-        offsetPage = address % pageSize;
-        // maximal 30 bytes to write
-        nextByte = min(min(remainingBytes, 32), pageSize - offsetPage);
-        Wire.beginTransmission(EEPROM_ADDRESS);
-        if (Wire.endTransmission() == 0) {
-            Wire.beginTransmission(EEPROM_ADDRESS);
-            Wire.write(address >> 8);
-            Wire.write(address & 0xFF);
-            byte *adr = byteBuffer + offsetDataBuffer;
-            Wire.write(adr, bytes);
-            Wire.endTransmission();
-            delay(10);
+DS3231StatsProbe::DS3231StatsProbe(DS3231& rtc, DS3231Method method) : rtc(rtc), method(method) {
+    start = DS3231::Bus::tally();
+    startMicros = micros();
+    rtc.statsDepth++;
+}
+
+DS3231StatsProbe::~DS3231StatsProbe() {
+    if(--rtc.statsDepth)
+        return; // called by another public method, counted there
+    const BusTally& now = DS3231::Bus::tally();
+    MethodStats& entry = rtc.stats[method];
+    entry.calls++;
+    entry.transactions += now.transactions - start.transactions;
+    entry.bytesWritten += now.bytesWritten - start.bytesWritten;
+    entry.bytesRead += now.bytesRead - start.bytesRead;
+    entry.micros += micros() - startMicros;
+}
+
+const MethodStats& DS3231::methodStats(DS3231Method method) const {
+    return stats[method];
+}
+
+void DS3231::resetStats() {
+    for(uint8_t i = 0; i < STAT_COUNT; i++)
+        stats[i] = MethodStats{0, 0, 0, 0, 0};
+}
+
+// right aligned in width characters
+static void printColumn(Print& out, uint32_t value, uint8_t width) {
+    uint8_t digits = 1;
+    for(uint32_t rest = value / 10; rest; rest /= 10)
+        digits++;
+    while(width-- > digits)
+        out.print(' ');
+    out.print(value);
+}
+
+/**
+ * @details The names are kept in flash and printed character by character, so the table costs no RAM.
+ */
+void DS3231::dumpStats(Print& out) {
+    out.println(F("method             calls        tx   written      read        us   us/call"));
+    for(uint8_t i = 0; i < STAT_COUNT; i++){
+        const MethodStats& entry = stats[i];
+        if(entry.calls == 0)
+            continue;
+        uint8_t length = 0;
+        for(char c; (c = pgm_read_byte(&STAT_NAMES[i][length])); length++)
+            out.print(c);
+        while(length++ < 14)
+            out.print(' ');
+        printColumn(out, entry.calls, 10);
+        printColumn(out, entry.transactions, 10);
+        printColumn(out, entry.bytesWritten, 10);
+        printColumn(out, entry.bytesRead, 10);
+        printColumn(out, entry.micros, 10);
+        printColumn(out, entry.micros / entry.calls, 10);
+        out.println();
+    }
+}
+#endif
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                           Interact with the EEPROM
+---------------------------------------------------------------------------------------------------------------------*/
+
+/**
+ * @details Waiting ends: every poll() completes or drops part of the queue within a bounded number of calls.
+ */
+BusStatus DS3231::writeEEPROM(uint16_t address, const uint8_t byteBuffer[], uint16_t bytes){
+    BusStatus result = BUS_OK;
+    while (bytes > 0) {
+        uint16_t nextBytes = min(bytes, (uint16_t)EEPROM_QUEUE_SIZE);
+        // only waits when the queue is full
+        while (!writeEEPROMAsync(address, byteBuffer, nextBytes)){
+            BusStatus status = poll();
+            if(result == BUS_OK)
+                result = status;
         }
-        //write(address, dataBuffer, offsetDataBuffer, nextByte);
-        remainingBytes -= nextByte;
-        offsetDataBuffer += nextByte;
-        address += nextByte;
+        address += nextBytes;
+        byteBuffer += nextBytes;
+        bytes -= nextBytes;
     }
+    return result;
 }
 
-void DS3231::readEEPROM(uint16_t address, uint8_t byteBuffer[], const uint16_t bytes) {
+BusStatus DS3231::readEEPROM(uint16_t address, uint8_t byteBuffer[], const uint16_t bytes) {
+    flushEEPROM(); // pending writes would be read as old data
+    BusStatus result = BUS_OK;
     int remainingBytes = bytes;
     int offsetDataBuffer = 0;
     // read until are bytes bytes read
     while (remainingBytes > 0) {
-        // read maximum 32 bytes
+        // read maximum Bus::MAX_TRANSFER bytes
         int nextByte = remainingBytes;
-        if (nextByte > 32) { nextByte = 32;}
-        Wire.beginTransmission(EEPROM_ADDRESS);
-        if (Wire.endTransmission() == 0) {
-            Wire.beginTransmission(EEPROM_ADDRESS);
-            Wire.write(address >> 8);
-            Wire.write(address & 0xFF);
-            if (Wire.endTransmission() == 0) {
-                int r = 0;
-                Wire.requestFrom(EEPROM_ADDRESS, bytes);
-                while (Wire.available() > 0 && r < bytes) {
-                    byteBuffer[offsetDataBuffer + r] = (byte)Wire.read();
-                    r++;
-                }
-            }
-        }
+        if (nextByte > Bus::MAX_TRANSFER) { nextByte = Bus::MAX_TRANSFER;}
+        BusStatus status;
+        uint8_t attempt = 0;
+        do{
+            Bus::beginWrite(EEPROM_ADDRESS);
+            Bus::write(address >> 8);
+            Bus::write(address & 0xFF);
+            status = BusStatus(Bus::endWrite(false));
+            if(status == BUS_OK && Bus::read(EEPROM_ADDRESS, byteBuffer + offsetDataBuffer, nextByte) != nextByte)
+                status = BUS_SHORT_READ;
+        } while(retry(eepromCounters, status, attempt++));
+        if(result == BUS_OK)
+            result = status;
         address += nextByte;
         offsetDataBuffer += nextByte;
         remainingBytes -= nextByte;
     }
+    lastBusStatus = result;
+    return result;
+}
+
+bool DS3231::probeEEPROM() {
+    Bus::beginWrite(EEPROM_ADDRESS);
+    return Bus::endWrite(true) == 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                         NON-BLOCKING EEPROM WRITES
+---------------------------------------------------------------------------------------------------------------------*/
+
+bool DS3231::writeEEPROMAsync(uint16_t address, const uint8_t byteBuffer[], uint16_t bytes) {
+    if(bytes == 0)
+        return true;
+    if(jobCount == EEPROM_QUEUE_JOBS || bytes > EEPROM_QUEUE_SIZE - dataCount)
+        return false;
+    for(uint16_t i = 0; i < bytes; i++)
+        eepromQueue[(dataHead + dataCount + i) % EEPROM_QUEUE_SIZE] = byteBuffer[i];
+    dataCount += bytes;
+    EEPROMJob& job = eepromJobs[(jobHead + jobCount) % EEPROM_QUEUE_JOBS];
+    job.address = address;
+    job.length = bytes;
+    jobCount++;
+    return true;
+}
+
+void DS3231::dropEEPROMJob() {
+    EEPROMJob& job = eepromJobs[jobHead];
+    dataHead = (dataHead + job.length) % EEPROM_QUEUE_SIZE;
+    dataCount -= job.length;
+    jobHead = (jobHead + 1) % EEPROM_QUEUE_JOBS;
+    jobCount--;
+    eepromAttempts = 0;
+}
+
+/**
+ * @details Each call does at most one bus transaction: an acknowledge poll while a write cycle runs,
+ * otherwise the next chunk of the oldest write. A chunk never crosses a page boundary (the EEPROM would
+ * wrap inside the page) and never exceeds what the bus transport carries in one transaction.
+ * Failures go through retry() like those of every other transaction, but a retry is the next call rather than a
+ * loop, so the queue never holds the caller longer than the backoff. Once the acknowledge polls of a write cycle
+ * that outlasted EEPROM_WRITE_TIMEOUT_MS have used up their retries, the chunk is taken as lost and the next one is
+ * sent, which drops its write if the EEPROM is really gone.
+ */
+BusStatus DS3231::poll() {
+    DS3231_STAT(STAT_POLL);
+    if(eepromBusy){
+        if(!DS3231::probeEEPROM()){
+            if(millis() - eepromBusySince <= EEPROM_WRITE_TIMEOUT_MS)
+                return BUS_OK; // still programming
+            if(retry(eepromCounters, BUS_NACK_ADDRESS, eepromAttempts++))
+                return BUS_OK;
+            eepromBusy = false;
+            eepromAttempts = 0;
+            return BUS_NACK_ADDRESS;
+        }
+        eepromBusy = false;
+        eepromAttempts = 0;
+        if(jobCount == 0 && eepromCallback)
+            eepromCallback();
+    }
+    if(jobCount == 0)
+        return BUS_OK;
+    EEPROMJob& job = eepromJobs[jobHead];
+    uint8_t nextBytes = EEPROM_PAGE_SIZE - job.address % EEPROM_PAGE_SIZE;
+    if(nextBytes > EEPROM_CHUNK_SIZE)
+        nextBytes = EEPROM_CHUNK_SIZE;
+    if(nextBytes > job.length)
+        nextBytes = job.length;
+    Bus::beginWrite(EEPROM_ADDRESS);
+    Bus::write(job.address >> 8);
+    Bus::write(job.address & 0xFF);
+    for(uint8_t i = 0; i < nextBytes; i++)
+        Bus::write(eepromQueue[(dataHead + i) % EEPROM_QUEUE_SIZE]);
+    BusStatus status = BusStatus(Bus::endWrite(true));
+    if(retry(eepromCounters, status, eepromAttempts++))
+        return BUS_OK; // the same chunk is sent again on the next call
+    if(status != BUS_OK){
+        dropEEPROMJob();
+        return status;
+    }
+    eepromAttempts = 0;
+    eepromBusy = true;
+    eepromBusySince = millis();
+    dataHead = (dataHead + nextBytes) % EEPROM_QUEUE_SIZE;
+    dataCount -= nextBytes;
+    job.address += nextBytes;
+    job.length -= nextBytes;
+    if(job.length == 0){
+        jobHead = (jobHead + 1) % EEPROM_QUEUE_JOBS;
+        jobCount--;
+    }
+    return BUS_OK;
+}
+
+bool DS3231::eepromIdle() const {
+    return jobCount == 0 && !eepromBusy;
+}
+
+/**
+ * @details Ends even without an EEPROM: a chunk is sent at most retries + 1 times before its write is dropped, and
+ * a write cycle is polled for EEPROM_WRITE_TIMEOUT_MS and its retries at most (setRetryPolicy()).
+ */
+BusStatus DS3231::flushEEPROM() {
+    DS3231_STAT(STAT_POLL);
+    BusStatus result = BUS_OK;
+    while(!eepromIdle()){
+        BusStatus status = poll();
+        if(result == BUS_OK)
+            result = status;
+    }
+    return result;
+}
+
+void DS3231::onEEPROMWritten(void (*callback)()) {
+    eepromCallback = callback;
 }
 
 /*--------------------------------------------------------------------------------------------------------------------
@@ -269,7 +596,8 @@ const char* DS3231::monthStr(const Month month){
 ---------------------------------------------------------------------------------------------------------------------*/
 
 bool DS3231::is_12() {
-    uint8_t byte[1];
+    DS3231_STAT(STAT_HOUR_MODE);
+    uint8_t byte[1] = {0};
     DS3231::readRegister(REG_TIME + 2, byte, 1);
     return byte[0] >> 6; // return 6th bit
 }
@@ -279,25 +607,22 @@ bool DS3231::is_12() {
  * bits 6 and 5 so that the clock will run in 12 hour mode.
  */
 void DS3231::set_12() {
+    DS3231_STAT(STAT_HOUR_MODE);
     if(DS3231::is_12())
         return;
 
     uint8_t byte[1];
     uint8_t hour;
     bool pm = false;
-    DS3231::readRegister(REG_TIME + 2, byte, 1);
+    if(DS3231::readRegister(REG_TIME + 2, byte, 1) != BUS_OK)
+        return;
     hour = DS3231::BCDtoDEC(byte[0]);
-    if(hour == 0){
-        hour = 12;
+    // 0 -> 12 AM, 12 -> 12 PM, like the device counts
+    if(hour >= 12)
         pm = true;
-    }
-    else if(hour == 12)
-        pm = false;
-    else{
-        if(hour > 12)
-            pm = true;
-        hour %= 12;
-    }
+    hour %= 12;
+    if(hour == 0)
+        hour = 12;
     byte[0] = DS3231::DECtoBCD(hour);
     byte[0] = DS3231::setHigh(byte[0], 6);
     if(pm) byte[0] = DS3231::setHigh(byte[0], 5);
@@ -309,50 +634,53 @@ void DS3231::set_12() {
  * bits 6 and 5 so that the clock will run in 24 hour mode.
  */
 void DS3231::set_24() {
+    DS3231_STAT(STAT_HOUR_MODE);
     if(!DS3231::is_12())
         return;
     uint8_t byte[1];
-    DS3231::readRegister(REG_TIME + 2, byte, 1);
+    if(DS3231::readRegister(REG_TIME + 2, byte, 1) != BUS_OK)
+        return;
     // first disable unwanted bits, then convert
     byte[0] = DS3231::setLow(byte[0], 6);
     bool pm = (bool)(byte[0] >> 5);
     byte[0] = DS3231::setLow(byte[0], 5);
-    uint8_t hour = DS3231::BCDtoDEC(byte[0]);
-    if(hour == 12 && pm)
-        hour = 0;
-    else if(pm)
-        hour += 12;
+    // 12 AM -> 0, 12 PM -> 12
+    uint8_t hour = DS3231::BCDtoDEC(byte[0]) % 12 + (pm ? 12 : 0);
+    byte[0] = DS3231::DECtoBCD(hour);
     DS3231::writeRegister(REG_TIME + 2, byte, 1);
 }
 
 //change one unit of time
 // 0-> hour, 1-> minutes, 2->seconds
-// only for 24 hour mode
 /**
- * @details As of now, this method only works in 24 hour mode.
+ * @details The hour is given in 24 hour format and written in the mode the clock runs in.
  */
 void DS3231::setTime(uint8_t number, uint8_t value){
+    DS3231_STAT(STAT_SET_TIME);
     uint8_t byte[1];
     uint8_t reg;
+    uint8_t hour = clockTime.hour(), minutes = clockTime.minutes(), seconds = clockTime.seconds();
     switch (number) {
         case 0:
             reg = REG_TIME+2;
-            clockTime.hour = value % 24;
-            value %= 24;
+            hour = value % 24;
+            byte[0] = DS3231::encodeHour(hour, DS3231::is_12());
             break;
         case 1:
             reg = REG_TIME+1;
-            clockTime.minutes = value % 60;
-            value %= 60;
+            minutes = value % 60;
+            byte[0] = DS3231::DECtoBCD(minutes);
             break;
-        case 2:
+        default:
             reg = REG_TIME;
-            clockTime.seconds = value % 60;
-            value %= 60;
+            seconds = value % 60;
+            byte[0] = DS3231::DECtoBCD(seconds);
             break;
     }
-    byte[0] = DS3231::DECtoBCD(value);
     DS3231::writeRegister(reg, byte,1);
+    clockTime = RTCdata::fromDays(clockTime.days(), hour * 60 + minutes, seconds);
+    resyncRequested = true;
+    rescheduleAlarmTable(); // the next times were computed from the old time
 }
 
 /**
@@ -360,82 +688,104 @@ void DS3231::setTime(uint8_t number, uint8_t value){
  * to the device registers.
  */
 void DS3231::setTime(const uint8_t hours, const uint8_t minutes, const uint8_t seconds) {
+    DS3231_STAT(STAT_SET_TIME);
     uint8_t bytes[3];
     bytes[0] = DS3231::DECtoBCD(seconds % 60);
     bytes[1] = DS3231::DECtoBCD(minutes % 60);
-    bytes[2] = DS3231::DECtoBCD(hours % 24);
-    if(DS3231::is_12()){
-        bytes[2] = DS3231::setHigh(bytes[2], 6);
-        if(clockTime.pm)
-            bytes[2] = DS3231::setHigh(bytes[2], 5);
-    }
+    bytes[2] = DS3231::encodeHour(hours % 24, DS3231::is_12());
     DS3231::writeRegister(REG_TIME, bytes, 3);
-    clockTime.seconds = seconds;
-    clockTime.minutes = minutes;
-    clockTime.hour = hours;
+    resyncRequested = true;
+    clockTime = RTCdata::fromDays(clockTime.days(), hours % 24 * 60 + minutes % 60, seconds % 60);
+    rescheduleAlarmTable();
+}
+
+uint8_t DS3231::encodeHour(uint8_t hour, bool twelveHour) {
+    if(!twelveHour)
+        return DS3231::DECtoBCD(hour);
+    // bit 6 -> 12 hour mode, bit 5 -> PM; 0 -> 12 AM, 12 -> 12 PM
+    uint8_t code = DS3231::DECtoBCD((hour + 11) % 12 + 1) | 0x40;
+    if(hour >= 12)
+        code |= 0x20;
+    return code;
 }
 
 // 0->day, 1->date, 2->month, 3->year
 
 
 void DS3231::setDate(uint8_t number, uint16_t value) {
+    DS3231_STAT(STAT_SET_DATE);
     uint8_t byte[1];
     uint8_t reg;
     switch (number) {
         case 0:
-            reg = REG_DAY;
-            clockTime.day = dayOfWeek(value);
-            break;
+            // the day of week follows the date
+            DS3231::syncDayOfWeek();
+            resyncRequested = true;
+            return;
         case 1:
             reg = REG_DATE;
-            clockTime.date = value;
             break;
         case 2:
             reg = REG_DATE+1;
-            clockTime.month = Month(value);
             break;
-        case 3:
+        default:
             reg = REG_DATE+2;
-            clockTime.year = value;
-            value -= 2000;
+            // an RTCdata cannot hold the years after RTC_YEAR_MAX, so the century bit is never set
+            value = constrain(value, RTC_YEAR_MIN, RTC_YEAR_MAX) - 2000;
             break;
     }
-    // if we are changing the year
-    // we have to check the month register and modify
-    // the century bit ( MSB )
+    // if we are changing the year, a century bit set by someone else is cleared
     if(number == 3){
         uint8_t monthByte[1];
         //read month register
-        DS3231::readRegister(REG_DATE+1,monthByte,1);
-        if(value > 99){ // activate the century bit
-            monthByte[0] = DS3231::setHigh(monthByte[0],7);
-            value -= 100;
-        }
-        else{
-            // just in case it was active before, deactivate century bit
+        if(DS3231::readRegister(REG_DATE+1,monthByte,1) != BUS_OK)
+            return;
+        if(monthByte[0] & 0x80){
             monthByte[0] = DS3231::setLow(monthByte[0],7);
+            DS3231::writeRegister(REG_DATE+1,monthByte,1);
         }
-        // write the changed byte to the register
-        DS3231::writeRegister(REG_DATE+1,monthByte,1);
     }
+    // the month is written with the century bit cleared
+    value = DS3231::DECtoBCD(value);
     // convert byte to bcd format
-    byte[0] = DS3231::DECtoBCD(value);
+    byte[0] = value;
     DS3231::writeRegister(reg, byte,1);
+    DS3231::syncDayOfWeek();
+    resyncRequested = true;
+    rescheduleAlarmTable();
 }
 
+/**
+ * @details The day parameter is kept for compatibility; the day of week register is computed from the date.
+ * The year is clamped to RTC_YEAR_MIN - RTC_YEAR_MAX, the years an RTCdata can hold, so the century bit stays 0.
+ */
 void DS3231::setDate(const dayOfWeek day, const Month month, const uint8_t date, uint16_t year) {
+    DS3231_STAT(STAT_SET_DATE);
+    (void)day;
+    year = constrain(year, RTC_YEAR_MIN, RTC_YEAR_MAX);
+    uint16_t days = DS3231::daysFromCivil(year, month, date);
     uint8_t bytes[4];
     // converts data to BCD and stores it in bytes buffer
-    bytes[0] = DS3231::DECtoBCD((uint8_t)day);
+    bytes[0] = DS3231::weekday(days);
     bytes[1] = DS3231::DECtoBCD(date);
     bytes[2] = DS3231::DECtoBCD((uint8_t)month);
-    if(year > 2099 && year < 2200){
-        bytes[2] = DS3231::setHigh(bytes[2], 7); //activate century bit
-        year -= 100;
-    }
     bytes[3] = DS3231::DECtoBCD(year - 2000);
     //writes the bytes from the bytes buffer to the DS3231 starting with day register
     DS3231::writeRegister(0x03,bytes,4);
+    clockTime = RTCdata::fromDays(days, clockTime.minuteOfDay(), clockTime.seconds());
+    resyncRequested = true;
+    rescheduleAlarmTable();
+}
+
+void DS3231::syncDayOfWeek() {
+    uint8_t bytes[3];
+    if(DS3231::readRegister(REG_DATE, bytes, 3) != BUS_OK)
+        return;
+    uint16_t days = DS3231::daysFromCivil(2000 + DS3231::BCDtoDEC(bytes[2]) + (bytes[1] >> 7) * 100,
+                                          DS3231::BCDtoDEC(bytes[1] & 0x1F), DS3231::BCDtoDEC(bytes[0] & 0x3F));
+    uint8_t day[1] = {DS3231::weekday(days)};
+    DS3231::writeRegister(REG_DAY, day, 1);
+    clockTime = RTCdata::fromDays(days, clockTime.minuteOfDay(), clockTime.seconds());
 }
 
 /*--------------------------------------------------------------------------------------------------------------------
@@ -443,62 +793,506 @@ void DS3231::setDate(const dayOfWeek day, const Month month, const uint8_t date,
 ---------------------------------------------------------------------------------------------------------------------*/
 
 RTCdata DS3231::readTime() {
+    DS3231_STAT(STAT_READ_TIME);
+    if(!eepromIdle())
+        poll();
     // reads the clockTime and date registers
     uint8_t bytes[7];
-    uint8_t lastMinute = clockTime.minutes;
-    DS3231::readRegister(REG_TIME,bytes,7);
-    clockTime.seconds = DS3231::BCDtoDEC(bytes[0]);
-    clockTime.minutes = DS3231::BCDtoDEC(bytes[1]);
-    //check if clock runs in 12 hour mode
-    if(bytes[2] >> 6){
-        bytes[2] = DS3231::setLow(bytes[2], 6);
-        if(bytes[2] >> 5){
-            clockTime.pm = true;
-            bytes[2] = DS3231::setLow(bytes[2], 5);
-        }
-        else clockTime.pm = false;
-        clockTime.hour = DS3231::BCDtoDEC(bytes[2]);
+    uint32_t lastMinute = clockTime.packed >> 6;
+    if(DS3231::readRegister(REG_TIME,bytes,7) != BUS_OK)
+        return clockTime; // the last good time, nothing is decoded from a failed read
+    decodeTime(bytes);
+    if(lastMinute != clockTime.packed >> 6){ // minute has changed
+        int16_t temperature = DS3231::readQuarterCelcius();
+        if(lastBusStatus == BUS_OK)
+            sampleTemperature(temperature);
+    }
+    return clockTime;
+}
+
+/**
+ * @details The registers are read with one auto-incrementing burst starting at 0x00. The shadow copies of the
+ * control and status registers are refreshed from the same data.
+ */
+RTCsnapshot DS3231::readSnapshot() {
+    DS3231_STAT(STAT_READ_SNAPSHOT);
+    if(!eepromIdle())
+        poll();
+    uint8_t bytes[REG_COUNT];
+    uint32_t lastMinute = clockTime.packed >> 6;
+    RTCsnapshot snapshot;
+    if(DS3231::readRegister(REG_TIME, bytes, REG_COUNT) != BUS_OK){
+        // the last known state
+        snapshot.time = clockTime;
+        snapshot.alarm1 = alarm1;
+        snapshot.alarm2 = alarm2;
+        snapshot.control = controlShadow;
+        snapshot.status = statusShadow;
+        snapshot.aging = 0;
+        snapshot.temperature = lastSample;
+        return snapshot;
+    }
+    snapshot.alarm1 = DS3231::decodeAlarm(bytes + REG_ALARM1_SEC, true);
+    snapshot.alarm1.enabled = bytes[REG_CONTROL] & (1 << BIT_A1IE);
+    snapshot.alarm2 = DS3231::decodeAlarm(bytes + REG_ALARM2_MIN, false);
+    snapshot.alarm2.enabled = bytes[REG_CONTROL] & (1 << BIT_A2IE);
+    snapshot.control = bytes[REG_CONTROL];
+    snapshot.status = bytes[REG_STATUS];
+    snapshot.aging = (int8_t)bytes[REG_AGING];
+    snapshot.temperature = DS3231::decodeTemperature(bytes[REG_TEMP_INT], bytes[REG_TEMP_FLOAT]);
+    controlShadow = bytes[REG_CONTROL];
+    statusShadow = bytes[REG_STATUS] & ~STATUS_VOLATILE;
+    shadowValid = 0x03;
+    decodeTime(bytes);
+    snapshot.time = clockTime;
+    if(lastMinute != clockTime.packed >> 6) // minute has changed, the sample comes from the same burst
+        sampleTemperature(snapshot.temperature);
+    return snapshot;
+}
+
+void DS3231::decodeTime(const uint8_t bytes[]) {
+    clockTime = DS3231::decodeTimeRegisters(bytes);
+}
+
+/**
+ * @details Straight-line code: the 12/24 hour, PM and century bits are masked off instead of being tested and
+ * cleared, and every field goes through the branch-free BCDtoDEC. A 12 hour register is converted to 24 hours
+ * arithmetically. The day of week register is not used, it follows from the date. The registers are not modified.
+ */
+RTCdata DS3231::decodeTimeRegisters(const uint8_t bytes[]) {
+    uint8_t seconds = DS3231::BCDtoDEC(bytes[0] & 0x7F);
+    uint8_t minutes = DS3231::BCDtoDEC(bytes[1] & 0x7F);
+    // bit 6 set -> 12 hour mode and bit 5 is PM; 24 hour mode -> bit 5 is the 20 hours digit
+    uint8_t twelve = (bytes[2] >> 1) & 0x20;
+    uint8_t pm = (bytes[2] & twelve) >> 5;
+    uint8_t hour = DS3231::BCDtoDEC(bytes[2] & (0x3F ^ twelve));
+    // 12 AM -> 0, 12 PM -> 12, 1 - 11 PM -> 13 - 23
+    hour += 12 * pm - 12 * ((twelve >> 5) & (hour == 12));
+    uint8_t date = DS3231::BCDtoDEC(bytes[4] & 0x3F);
+    uint8_t month = DS3231::BCDtoDEC(bytes[5] & 0x1F);
+    uint16_t year = 2000 + DS3231::BCDtoDEC(bytes[6]) + (bytes[5] >> 7) * 100;
+    // the chip counts to 2199, an RTCdata does not: later dates saturate
+    if(year > RTC_YEAR_MAX + 1)
+        return RTCdata::fromDays(RTC_DAYS_MAX, 1439, 59);
+    uint16_t days = DS3231::daysFromCivil(year, month, date);
+    if(days > RTC_DAYS_MAX)
+        return RTCdata::fromDays(RTC_DAYS_MAX, 1439, 59);
+    return RTCdata::fromDays(days, hour * 60 + minutes, seconds);
+}
+
+RTCalarm DS3231::decodeAlarm(const uint8_t bytes[], bool hasSeconds) {
+    RTCalarm alarm;
+    if(hasSeconds){
+        alarm.seconds = DS3231::BCDtoDEC(bytes[0] & 0x7F);
+        bytes++;
     }
+    else alarm.seconds = 0;
+    alarm.minutes = DS3231::BCDtoDEC(bytes[0] & 0x7F);
+    alarm.hour = DS3231::BCDtoDEC(bytes[1] & 0x3F);
+    alarm.pm = false;
+    // A1M4/A2M4 set -> the day is ignored; DY/DT set -> day of week
+    if(!(bytes[2] & 0x80) && (bytes[2] & 0x40))
+        alarm.day = dayOfWeek(bytes[2] & 0x0F);
     else
-        clockTime.hour = DS3231::BCDtoDEC(bytes[2]);
-    clockTime.day = dayOfWeek(DS3231::BCDtoDEC(bytes[3]));
-    clockTime.date = DS3231::BCDtoDEC(bytes[4]);
-    uint8_t century = 0;
-    if(bytes[5] >> 7 == 1){
-        century = 100;
-        bytes[5] = DS3231::setLow(bytes[5],7);
-    }
-    clockTime.month = Month(DS3231::BCDtoDEC(bytes[5] & 0b00011111));
-    clockTime.year = DS3231::BCDtoDEC(bytes[6]) + 2000 + century;
-    if(lastMinute != clockTime.minutes) { // minute has changed
-        float temperature = DS3231::readCelcius();
-        last1hTemperature[timeKeep % 60] = temperature;
-        timeKeep++;
-    }
-    if(timeKeep == 60) { // hour has changed
-        float avrgTemperature = 0;
-        for(uint8_t i = 0; i < 60; i++) {
-            avrgTemperature += last1hTemperature[i];
-            last1hTemperature[i] = 0.0;
-        }
-        avrgTemperature /= 60.0;
-        for(int8_t i = 22; i >= 0; i--) {
-            last24hTemperature[i + 1] = last24hTemperature[i]; // discards oldest data and shift
+        alarm.day = DAILY;
+    alarm.enabled = false;
+    return alarm;
+}
+
+void DS3231::sampleTemperature(int16_t temperature) {
+    lastSample = temperature;
+    // constant time: the statistics of the current hour are kept up to date with every sample
+    last1hTemperature[timeKeep] = temperature;
+    timeKeep = (timeKeep + 1) % TEMP_HISTORY_MINUTES;
+    if(stored[TIER_MINUTE] < TEMP_HISTORY_MINUTES)
+        stored[TIER_MINUTE]++;
+    TempAggregate sample = {temperature, temperature, temperature};
+    DS3231::accumulate(currentHour, sample);
+    if(currentHour.count == DS3231::tierPeriods(TIER_HOUR)) { // hour has changed
+        sample = DS3231::aggregate(currentHour);
+        DS3231::clearAccumulator(currentHour);
+        closePeriod(TIER_HOUR, sample);
+    }
+}
+
+/**
+ * @details Only a closed period is written to the EEPROM: one record per hour, one more per day and per week.
+ */
+void DS3231::closePeriod(TempTier tier, const TempAggregate& aggregate) {
+    uint8_t size;
+    uint8_t* head;
+    TempAggregate* ring = tierRing(tier, size, head);
+    *head = (*head + 1) % size; // the oldest period is overwritten, nothing is shifted
+    ring[*head] = aggregate;
+    if(stored[tier] < size)
+        stored[tier]++;
+    appendLogRecord(tier, aggregate);
+    if(tier == TIER_WEEK)
+        return;
+    TempTier above = TempTier(tier + 1);
+    TempAccumulator& accumulator = tierAccumulator(above);
+    DS3231::accumulate(accumulator, aggregate);
+    if(accumulator.count == DS3231::tierPeriods(above)){
+        TempAggregate period = DS3231::aggregate(accumulator);
+        DS3231::clearAccumulator(accumulator);
+        closePeriod(above, period);
+    }
+}
+
+void DS3231::accumulate(TempAccumulator& accumulator, const TempAggregate& aggregate) {
+    accumulator.sum += aggregate.mean;
+    if(aggregate.min < accumulator.min)
+        accumulator.min = aggregate.min;
+    if(aggregate.max > accumulator.max)
+        accumulator.max = aggregate.max;
+    accumulator.count++;
+}
+
+TempAggregate DS3231::aggregate(const TempAccumulator& accumulator) {
+    TempAggregate aggregate;
+    // mean rounded to the nearest quarter degree
+    int32_t half = accumulator.count / 2;
+    aggregate.mean = (accumulator.sum >= 0 ? accumulator.sum + half : accumulator.sum - half) / accumulator.count;
+    aggregate.min = accumulator.min;
+    aggregate.max = accumulator.max;
+    return aggregate;
+}
+
+void DS3231::clearAccumulator(TempAccumulator& accumulator) {
+    accumulator.sum = 0;
+    accumulator.min = 0x7FFF;
+    accumulator.max = -0x8000;
+    accumulator.count = 0;
+}
+
+TempAggregate* DS3231::tierRing(TempTier tier, uint8_t& size, uint8_t*& head) {
+    switch(tier){
+        case TIER_DAY:
+            size = TEMP_HISTORY_DAYS;
+            head = &dayHead;
+            return lastWeekTemperature;
+        case TIER_WEEK:
+            size = TEMP_HISTORY_WEEKS;
+            head = &weekHead;
+            return lastMonthTemperature;
+        default:
+            size = TEMP_HISTORY_HOURS;
+            head = &hourHead;
+            return last24hTemperature;
+    }
+}
+
+TempAccumulator& DS3231::tierAccumulator(TempTier tier) {
+    switch(tier){
+        case TIER_DAY: return currentDay;
+        case TIER_WEEK: return currentWeek;
+        default: return currentHour;
+    }
+}
+
+uint8_t DS3231::tierPeriods(TempTier tier) {
+    switch(tier){
+        case TIER_HOUR: return 60;
+        case TIER_DAY: return 24;
+        case TIER_WEEK: return 7;
+        default: return 1;
+    }
+}
+
+uint8_t DS3231::currentHourTemperature(int16_t& mean, int16_t& min, int16_t& max) const {
+    if(currentHour.count == 0)
+        return 0;
+    TempAggregate hour = DS3231::aggregate(currentHour);
+    mean = hour.mean;
+    min = hour.min;
+    max = hour.max;
+    return currentHour.count;
+}
+
+uint8_t DS3231::currentTemperature(TempTier tier, TempAggregate& temperature) {
+    if(tier == TIER_MINUTE)
+        return 0;
+    TempAccumulator& accumulator = tierAccumulator(tier);
+    if(accumulator.count)
+        temperature = DS3231::aggregate(accumulator);
+    return accumulator.count;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                               EPOCH TIME
+---------------------------------------------------------------------------------------------------------------------*/
+
+// days from March 1 to the first day of each month (the year starts in March, so February 29 is its last day)
+static const uint16_t DAYS_BEFORE_MONTH[12] PROGMEM = {306, 337, 0, 31, 61, 92, 122, 153, 184, 214, 245, 275};
+// days from 1996-03-01 to 2000-01-01
+#define EPOCH_BASE_DAYS 1401
+// days from 1996-03-01 to 2100-03-01, the first day after the only skipped leap day of the range
+#define EPOCH_2100_DAYS 37985
+
+RTCepoch DS3231::readEpoch() {
+    DS3231_STAT(STAT_READ_TIME);
+    return DS3231::readTime().epoch();
+}
+
+RTCepoch DS3231::softEpoch() {
+    DS3231_STAT(STAT_SOFT_TIME);
+    return DS3231::softTime().epoch();
+}
+
+/**
+ * @details Years are counted from 1996-03-01, so the leap day is the last day of a year and every 4th year is a
+ * leap year. The arithmetic holds up to 2135, whose only exception is 2100, handled by one comparison; the dates
+ * used are the years of an RTCdata (RTC_YEAR_MIN - RTC_YEAR_MAX).
+ */
+uint16_t DS3231::daysFromCivil(uint16_t year, uint8_t month, uint8_t date) {
+    uint8_t years = year - 1996 - (month <= 2); // years started in March
+    return 365U * years + (years >> 2) - (years >= 104) + pgm_read_word(&DAYS_BEFORE_MONTH[month - 1]) + date - 1 -
+           EPOCH_BASE_DAYS;
+}
+
+/**
+ * @details The missing leap day of 2100 is added back, so the days fall into uniform 4 year cycles of 1461 days;
+ * the month comes from the day of the (March based) year like in days_from_civil / civil_from_days by H. Hinnant.
+ */
+void DS3231::civilFromDays(uint16_t days, uint16_t& year, uint8_t& month, uint8_t& date) {
+    uint16_t shifted = days + EPOCH_BASE_DAYS;
+    shifted += shifted >= EPOCH_2100_DAYS;
+    // (4 * shifted + 3) / 1461 split up so that it stays in 16 bits
+    uint16_t cycles = shifted / 1461;
+    uint8_t years = 4 * cycles + (4 * (shifted - cycles * 1461) + 3) / 1461;
+    uint16_t dayOfYear = shifted - (365U * years + (years >> 2)); // 0 -> March 1
+    uint8_t monthIndex = (5 * dayOfYear + 2) / 153; // 0 -> March
+    date = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = 1996 + years + (month <= 2);
+}
+
+// 2000-01-01 was a Saturday
+dayOfWeek DS3231::weekday(uint16_t days) {
+    return dayOfWeek((days + SATURDAY - 1) % 7 + 1);
+}
+
+uint8_t DS3231::daysInMonth(uint16_t year, uint8_t month) {
+    if(month == FEBRUARY)
+        return 28 + (year % 4 == 0 && year != 2100);
+    // 31 days in odd months until July, in even months from August
+    return 30 + ((month ^ (month >> 3)) & 1);
+}
+
+/**
+ * @details The alarm is an offset into a day or a week counted from epoch 0; the last match is now minus the
+ * distance from that offset, modulo the period.
+ */
+RTCepoch DS3231::previousOccurrence(RTCepoch now, const RTCalarm& alarm) {
+    uint32_t period = EPOCH_DAY;
+    uint32_t offset = alarm.hour * EPOCH_HOUR + alarm.minutes * EPOCH_MINUTE + alarm.seconds;
+    if(alarm.day != DAILY){
+        period = EPOCH_WEEK;
+        offset += ((alarm.day + 7 - SATURDAY) % 7) * EPOCH_DAY;
+    }
+    return now - (now + period - offset) % period;
+}
+
+RTCepoch DS3231::nextOccurrence(RTCepoch now, const RTCalarm& alarm) {
+    return DS3231::previousOccurrence(now, alarm) + (alarm.day == DAILY ? EPOCH_DAY : EPOCH_WEEK);
+}
+
+dayOfWeek RTCdata::day() const {
+    return DS3231::weekday(days());
+}
+
+uint8_t RTCdata::date() const {
+    uint16_t year;
+    uint8_t month, date;
+    DS3231::civilFromDays(days(), year, month, date);
+    return date;
+}
+
+Month RTCdata::month() const {
+    uint16_t year;
+    uint8_t month, date;
+    DS3231::civilFromDays(days(), year, month, date);
+    return Month(month);
+}
+
+uint16_t RTCdata::year() const {
+    uint16_t year;
+    uint8_t month, date;
+    DS3231::civilFromDays(days(), year, month, date);
+    return year;
+}
+
+RTCepoch RTCdata::epoch() const {
+    return days() * EPOCH_DAY + minuteOfDay() * EPOCH_MINUTE + seconds();
+}
+
+RTCdata RTCdata::make(uint16_t year, uint8_t month, uint8_t date, uint8_t hour, uint8_t minutes, uint8_t seconds) {
+    return RTCdata::fromDays(DS3231::daysFromCivil(year, month, date), hour * 60 + minutes, seconds);
+}
+
+RTCdata RTCdata::fromEpoch(RTCepoch epoch) {
+    if(epoch >= (RTC_DAYS_MAX + 1UL) * EPOCH_DAY)
+        return RTCdata::fromDays(RTC_DAYS_MAX, 1439, 59);
+    uint32_t minutes = epoch / 60;
+    uint16_t days = minutes / 1440;
+    return RTCdata::fromDays(days, minutes - days * 1440UL, epoch - minutes * 60);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                             SOFTWARE CLOCK
+---------------------------------------------------------------------------------------------------------------------*/
+
+/**
+ * @details The time keeping registers are read once, then the 1Hz square wave is enabled on the INT/SQW pin.
+ */
+void DS3231::beginSoftClock(uint16_t resyncMinutes) {
+    DS3231_STAT(STAT_SOFT_CLOCK);
+    this->resyncMinutes = resyncMinutes ? resyncMinutes : 1;
+    DS3231::setSQW(0); // 1Hz
+    DS3231::toggleSQW(true);
+    softClock = true;
+    softAlarmFlags = 0;
+    minutesSinceSync = 0;
+    resyncRequested = false;
+    readTime();
+    pendingTicks = 0;
+}
+
+void DS3231::endSoftClock() {
+    DS3231_STAT(STAT_SOFT_CLOCK);
+    softClock = false;
+    DS3231::toggleSQW(false); // INTCN back to 1, alarms can pull the pin low again
+    readTime();
+}
+
+void DS3231::tick() {
+    if(pendingTicks < 0xFF)
+        pendingTicks++;
+}
+
+/**
+ * @details The registers are read when softTime() is called, which is not always right after an edge: after a wake
+ * up by a button, say. An edge counted while the registers are read may or may not be in the time read, so the read
+ * is repeated until no edge came during it. A count that saturated (softTime() not called for 255 seconds) has lost
+ * seconds: the registers are read then too. The device sets A1F and A2F on a match whatever INTCN is, so the status
+ * register read with the time gives the matches of the seconds that were never counted; only the flags of enabled
+ * alarms are taken, snoozeAlarm() clears both.
+ */
+RTCdata DS3231::softTime() {
+    DS3231_STAT(STAT_SOFT_TIME);
+    if(!softClock)
+        return readTime();
+    if(!eepromIdle())
+        poll();
+    noInterrupts();
+    uint8_t ticks = pendingTicks;
+    pendingTicks = 0;
+    interrupts();
+    if(ticks == 0xFF)
+        resyncRequested = true;
+    if(ticks == 0 && !resyncRequested)
+        return clockTime;
+    while(ticks--) {
+        uint32_t lastMinute = clockTime.packed >> 6;
+        advanceSecond();
+        // alarm 1 and the alarm table may ring at any second; alarm 1 then holds the root of the table
+#if ALARM_TABLE_ENTRIES
+        if(alarmTableCount ? clockTime >= alarmTable[0].next : alarmMatches(alarm1, alarm1.seconds))
+#else
+        if(alarmMatches(alarm1, alarm1.seconds))
+#endif
+            softAlarmFlags |= 0x01;
+        if(lastMinute == clockTime.packed >> 6)
+            continue;
+        // new minute: temperature sample and alarm match, no time read
+        minutesSinceSync++;
+        int16_t temperature = DS3231::readQuarterCelcius();
+        if(lastBusStatus == BUS_OK)
+            sampleTemperature(temperature);
+        if(alarmMatches(alarm2, 0))
+            softAlarmFlags |= 0x02;
+    }
+    if(resyncRequested || minutesSinceSync >= resyncMinutes) {
+        do{
+            noInterrupts();
+            pendingTicks = 0;
+            interrupts();
+            readTime();
+        } while(pendingTicks != 0);
+        // a match the counted seconds jumped over still set its flag in the device
+        uint8_t status[1];
+        if(DS3231::readRegister(REG_STATUS, status, 1) == BUS_OK){
+            statusShadow = status[0] & ~STATUS_VOLATILE;
+            shadowValid |= 0x02;
+            if(alarm1.enabled)
+                softAlarmFlags |= status[0] & (1 << BIT_A1F);
+            if(alarm2.enabled)
+                softAlarmFlags |= status[0] & (1 << BIT_A2F);
         }
-        last24hTemperature[0] = avrgTemperature;
-        storeTemperature();
-        timeKeep = 0;
+        minutesSinceSync = 0;
+        resyncRequested = false;
     }
     return clockTime;
 }
 
+void DS3231::requestResync() {
+    resyncRequested = true;
+}
+
+bool DS3231::softClockRunning() const {
+    return softClock;
+}
+
+bool DS3231::sleepReady() const {
+    return eepromIdle() && pendingTicks == 0;
+}
+
+bool DS3231::alarmPending() {
+    DS3231_STAT(STAT_SOFT_TIME);
+    if(softClock)
+        softTime();
+    return softAlarmFlags != 0;
+}
+
+int16_t DS3231::lastTemperature() const {
+    return lastSample;
+}
+
+/**
+ * @details The fields of RTCdata are packed from seconds up, so every carry is a single addition to the packed value:
+ * 60 seconds are replaced by one minute and 1440 minutes by one day. 12 hour mode needs no special case because the
+ * time is kept in 24 hours.
+ */
+void DS3231::advanceSecond() {
+    clockTime.packed++;
+    if(clockTime.seconds() < 60)
+        return;
+    clockTime.packed += (1UL << 6) - 60;
+    if(clockTime.minuteOfDay() < 1440)
+        return;
+    clockTime.packed += (1UL << 17) - (1440UL << 6);
+}
+
+bool DS3231::alarmMatches(const RTCalarm& alarm, uint8_t seconds) const {
+    if(!alarm.enabled || clockTime.seconds() != seconds)
+        return false;
+    if(clockTime.minutes() != alarm.minutes || clockTime.hour() != alarm.hour)
+        return false;
+    return alarm.day == DAILY || alarm.day == clockTime.day();
+}
+
 /*--------------------------------------------------------------------------------------------------------------------
  *                                             EDIT ALARMS
 ---------------------------------------------------------------------------------------------------------------------*/
 
 uint8_t DS3231::checkAlarmFlag() {
+    DS3231_STAT(STAT_CHECK_ALARM_FLAG);
+    // the flags are set by the device, the register always has to be read
     uint8_t byte[1];
-    DS3231::readRegister(REG_STATUS,byte,1);
+    if(DS3231::readRegister(REG_STATUS,byte,1) != BUS_OK)
+        return 3; // no flag seen
+    statusShadow = byte[0] & ~STATUS_VOLATILE;
+    shadowValid |= 0x02;
     bool alarm1Flag, alarm2Flag;
     alarm1Flag = (bool)(byte[0] & 0x01);
     alarm2Flag = (bool)(byte[0] & 0x02);
@@ -512,6 +1306,8 @@ uint8_t DS3231::checkAlarmFlag() {
 }
 
 RTCalarm DS3231::readAlarm(const uint8_t alarmNumber) {
+    if(const RTCalarm* kept = DS3231::keptAlarm(alarmNumber))
+        return *kept;
     switch (alarmNumber) {
         case 1:
             return alarm1;
@@ -524,6 +1320,8 @@ RTCalarm DS3231::readAlarm(const uint8_t alarmNumber) {
 }
 
 bool DS3231::alarmState(uint8_t alarmNumber) const {
+    if(const RTCalarm* kept = DS3231::keptAlarm(alarmNumber))
+        return kept->enabled;
     switch (alarmNumber) {
         case 1:
             return alarm1.enabled;
@@ -535,36 +1333,49 @@ bool DS3231::alarmState(uint8_t alarmNumber) const {
 }
 
 void DS3231::toggleAlarm(const uint8_t alarmNumber, bool enable) {
+    DS3231_STAT(STAT_TOGGLE_ALARM);
+    if(RTCalarm* kept = DS3231::keptAlarm(alarmNumber)){
+        kept->enabled = enable; // the table holds the registers
+        return;
+    }
     snoozeAlarm(); // in case alarm flag were activated but the alarm interrupts were off
-    uint8_t byte[1];
-    DS3231::readRegister(REG_CONTROL, byte, 1);
+    uint8_t control = DS3231::readControl();
     switch (alarmNumber) {
         case 1:
             alarm1.enabled = enable;
             if(enable){
-                byte[0] = DS3231::setHigh(byte[0], 0); // set A1IE to 1
+                control = DS3231::setHigh(control, BIT_A1IE); // set A1IE to 1
             }
             else{
-                byte[0] = DS3231::setLow(byte[0], 0); // set A1IE to 0
+                control = DS3231::setLow(control, BIT_A1IE); // set A1IE to 0
             }
             break;
         case 2:
             alarm2.enabled = enable;
             if(enable){
-                byte[0] = DS3231::setHigh(byte[0], 1); // set A12E to 1
+                control = DS3231::setHigh(control, BIT_A2IE); // set A12E to 1
             }
             else{
-                byte[0] = DS3231::setLow(byte[0], 1); // set A2IE to 0
+                control = DS3231::setLow(control, BIT_A2IE); // set A2IE to 0
             }
             break;
     }
-    if(!INTCtr)
-        writeINTCtr(true); // enables INTC bit in case it's disabled
-    DS3231::writeRegister(REG_CONTROL, byte, 1);
+    // enables INTC bit in case it's disabled, in the same write as the interrupt enable bits
+    // (unless the software clock needs the square wave; its alarms are then matched in RAM)
+    if(!softClock){
+        control = DS3231::setHigh(control, BIT_INTCN);
+        INTCtr = true;
+    }
+    DS3231::writeControl(control);
 }
 
 //copies alarm information
 void DS3231::setAlarm(uint8_t alarmNumber, RTCalarm &alarm) {
+    DS3231_STAT(STAT_SET_ALARM);
+    if(RTCalarm* kept = DS3231::keptAlarm(alarmNumber)){
+        *kept = alarm;
+        return;
+    }
     switch (alarmNumber) {
         case 1:
             alarm1 = alarm;
@@ -576,6 +1387,14 @@ void DS3231::setAlarm(uint8_t alarmNumber, RTCalarm &alarm) {
 }
 
 void DS3231::setAlarmDaily(const uint8_t alarmNumber, uint8_t hour, const uint8_t minute) {
+    DS3231_STAT(STAT_SET_ALARM);
+    if(RTCalarm* kept = DS3231::keptAlarm(alarmNumber)){
+        kept->seconds = 0;
+        kept->minutes = minute;
+        kept->hour = hour;
+        kept->day = DAILY;
+        return; // programmed when the table empties
+    }
     uint8_t bytes[4];
     bytes[0] = 0x00; // alarm starts at seconds 00;
     bytes[1] = DECtoBCD(minute);
@@ -610,6 +1429,14 @@ void DS3231::setAlarmDaily(const uint8_t alarmNumber, uint8_t hour, const uint8_
 }
 
 void DS3231::setAlarmWeekly(uint8_t alarmNumber, uint8_t hour, const uint8_t minute, const dayOfWeek day) {
+    DS3231_STAT(STAT_SET_ALARM);
+    if(RTCalarm* kept = DS3231::keptAlarm(alarmNumber)){
+        kept->seconds = 0;
+        kept->minutes = minute;
+        kept->hour = hour;
+        kept->day = day;
+        return; // programmed when the table empties
+    }
     uint8_t bytes[4];
     bytes[0] = 0x00; // alarm starts at seconds 00;
     bytes[1] = DS3231::DECtoBCD(minute);
@@ -644,28 +1471,73 @@ void DS3231::setAlarmWeekly(uint8_t alarmNumber, uint8_t hour, const uint8_t min
     }
 }
 
+void DS3231::encodeAlarm(const RTCalarm& alarm, uint8_t bytes[]) {
+    bytes[0] = DS3231::DECtoBCD(alarm.seconds);
+    bytes[1] = DS3231::DECtoBCD(alarm.minutes);
+    bytes[2] = DS3231::DECtoBCD(alarm.hour);
+    // A1M4 set -> the day is not matched; DY/DT set -> the day of the week is matched
+    bytes[3] = alarm.day == DAILY ? 0x80 : 0x40 | alarm.day;
+}
+
+/**
+ * @details The registers the alarm was programmed with are known from the RAM copy, so the old and the new alarm
+ * are encoded and only the run from the first to the last register that differs is written, in one transaction.
+ * The table programs alarm 1 as a date match alarm, which the RAM copy does not hold: writing it would both lose
+ * the next alarm of the table and break the comparison, so alarm 1 is refused while the table holds alarms.
+ */
+bool DS3231::updateAlarm(uint8_t alarmNumber, const RTCalarm& alarm) {
+    DS3231_STAT(STAT_SET_ALARM);
+    if(alarmNumber != 2 && (alarmNumber != 1 || alarmTableCount != 0))
+        return false;
+    RTCalarm& current = alarmNumber == 1 ? alarm1 : alarm2;
+    uint8_t before[4], after[4];
+    DS3231::encodeAlarm(current, before);
+    RTCalarm next = alarm;
+    next.seconds = alarmNumber == 1 ? alarm.seconds % 60 : 0;
+    next.minutes = alarm.minutes % 60;
+    next.hour = alarm.hour % 24;
+    next.day = (dayOfWeek)(alarm.day % 8);
+    next.pm = next.hour >= 12;
+    next.enabled = current.enabled;
+    DS3231::encodeAlarm(next, after);
+    uint8_t first = alarmNumber == 1 ? 0 : 1; // alarm 2 has no seconds register
+    uint8_t last = 3;
+    while(first <= last && before[first] == after[first])
+        first++;
+    while(last > first && before[last] == after[last])
+        last--;
+    current = next;
+    if(first > last)
+        return true; // nothing to write
+    uint8_t reg = (alarmNumber == 1 ? REG_ALARM1_SEC : REG_ALARM2_MIN - 1) + first;
+    DS3231::writeRegister(reg, after + first, last - first + 1);
+    return true;
+}
+
 //disable alarm flags
 void DS3231::snoozeAlarm() {
-    uint8_t byte[1];
-    DS3231::readRegister(REG_STATUS,byte,1);
-    byte[0] = DS3231::setLow(byte[0],0);
-    byte[0] = DS3231::setLow(byte[0],1);
-    DS3231::writeRegister(REG_STATUS,byte,1);
-    //restore the INT bit state
-    //DS3231::readRegister(REG_CONTROL,byte,1);
-    //DS3231::writeINTCtr(INTCtr); // restore INTCN bit's state
+    DS3231_STAT(STAT_SNOOZE_ALARM);
+    // A1F & A2F are written 0 (cleared), OSF is written 1 (left unchanged), EN32kHz comes from the shadow
+    uint8_t status = DS3231::readStatus() | STATUS_CLEAR_ONLY;
+    status = DS3231::setLow(status, BIT_A1F);
+    status = DS3231::setLow(status, BIT_A2F);
+    DS3231::writeStatus(status);
+    softAlarmFlags = 0;
 }
 
 void DS3231::storeAlarmEEPROM(uint8_t alarmNumber) {
+    DS3231_STAT(STAT_ALARM_EEPROM);
     uint8_t bytes[5];
     uint16_t address;
+    // while the table holds the registers, the alarm 1 of the user is stored, not the table's
+    const RTCalarm& user1 = DS3231::keptAlarm(1) ? *DS3231::keptAlarm(1) : alarm1;
     switch (alarmNumber) {
         case 1:
-            bytes[0] = alarm1.seconds;
-            bytes[1] = alarm1.minutes;
-            bytes[2] = alarm1.hour;
-            bytes[3] = (uint8_t)alarm1.day;
-            bytes[4] = alarm1.enabled;
+            bytes[0] = user1.seconds;
+            bytes[1] = user1.minutes;
+            bytes[2] = user1.hour;
+            bytes[3] = (uint8_t)user1.day;
+            bytes[4] = user1.enabled;
             address = ALARM1_ADDRESS;
             break;
         case 2:
@@ -681,6 +1553,7 @@ void DS3231::storeAlarmEEPROM(uint8_t alarmNumber) {
 }
 
 RTCalarm DS3231::readAlarmEEPROM(uint8_t alarmNumber) {
+    DS3231_STAT(STAT_ALARM_EEPROM);
     uint16_t address;
     uint8_t byteBuffer[5];
     switch (alarmNumber) {
@@ -692,7 +1565,8 @@ RTCalarm DS3231::readAlarmEEPROM(uint8_t alarmNumber) {
             break;
     }
     RTCalarm alarm;
-    DS3231::readEEPROM(address, byteBuffer, 5);
+    if(DS3231::readEEPROM(address, byteBuffer, 5) != BUS_OK)
+        memset(byteBuffer, 0, sizeof(byteBuffer)); // 00:00:00 daily, disabled
     alarm.seconds = byteBuffer[0] % 60;
     alarm.minutes = byteBuffer[1] % 60;
     alarm.hour = byteBuffer[2] % 24;
@@ -702,51 +1576,440 @@ RTCalarm DS3231::readAlarmEEPROM(uint8_t alarmNumber) {
     return alarm;
 }
 
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                              ALARM TABLE
+---------------------------------------------------------------------------------------------------------------------*/
+
+void DS3231::takeAlarmTable() {
+    alarmTableCount = 0;
+#if ALARM_TABLE_ENTRIES
+    uint8_t header[2];
+    if(readEEPROM(ALARM_TABLE_HEADER, header, 2) != BUS_OK)
+        return; // starts with an empty table, the header is not rewritten
+    if(header[0] != ALARM_TABLE_MAGIC || header[1] != ALARM_TABLE_VERSION){
+        // every slot up to the temperature log, so a build with more ALARM_TABLE_ENTRIES finds them free too
+        uint8_t empty[EEPROM_PAGE_SIZE];
+        memset(empty, 0xFF, sizeof(empty));
+        for(uint16_t address = ALARM_TABLE_START; address < TEMP_LOG_START; address += EEPROM_PAGE_SIZE)
+            writeEEPROM(address, empty, EEPROM_PAGE_SIZE);
+        header[0] = ALARM_TABLE_MAGIC;
+        header[1] = ALARM_TABLE_VERSION;
+        writeEEPROM(ALARM_TABLE_HEADER, header, 2);
+        return;
+    }
+    readAlarmTable();
+#endif
+}
+
+/**
+ * @details A new time moves the next time of every alarm but none of the alarms: the entries keep their time and,
+ * for a weekly alarm, their day of the week in next, so the alarms are rebuilt in RAM and no record is read.
+ */
+void DS3231::rescheduleAlarmTable() {
+#if ALARM_TABLE_ENTRIES
+    if(alarmTableCount == 0)
+        return;
+    RTCepoch now = clockTime.epoch();
+    for(uint8_t i = 0; i < alarmTableCount; i++)
+        alarmTable[i].next = RTCdata::fromEpoch(DS3231::nextOccurrence(now, DS3231::tableEntryAlarm(alarmTable[i])));
+    heapifyAlarmTable();
+    programAlarmTable();
+#endif
+}
+
+uint8_t DS3231::tableAlarmCount() const {
+    return alarmTableCount;
+}
+
+RTCalarm* DS3231::keptAlarm(uint8_t alarmNumber) {
+#if ALARM_TABLE_ENTRIES
+    if(alarmNumber == 1 && alarmTableCount)
+        return &userAlarm1;
+#endif
+    (void)alarmNumber;
+    return nullptr;
+}
+
+const RTCalarm* DS3231::keptAlarm(uint8_t alarmNumber) const {
+#if ALARM_TABLE_ENTRIES
+    if(alarmNumber == 1 && alarmTableCount)
+        return &userAlarm1;
+#endif
+    (void)alarmNumber;
+    return nullptr;
+}
+
+#if ALARM_TABLE_ENTRIES
+RTCdata DS3231::currentTime() {
+    return softClock ? softTime() : readTime();
+}
+
+bool DS3231::decodeTableRecord(const uint8_t record[], RTCalarm& alarm) {
+    if(record[0] > SUNDAY || record[1] > 23 || record[2] > 59 || record[3] > 59)
+        return false; // 0xFF -> free slot
+    alarm.day = (dayOfWeek)record[0];
+    alarm.hour = record[1];
+    alarm.minutes = record[2];
+    alarm.seconds = record[3];
+    alarm.pm = alarm.hour >= 12;
+    alarm.enabled = true;
+    return true;
+}
+
+RTCalarm DS3231::tableEntryAlarm(const AlarmTableEntry& entry) {
+    RTCalarm alarm;
+    alarm.seconds = entry.next.seconds();
+    alarm.minutes = entry.next.minutes();
+    alarm.hour = entry.next.hour();
+    alarm.day = entry.weekly ? entry.next.day() : DAILY;
+    alarm.pm = alarm.hour >= 12;
+    alarm.enabled = true;
+    return alarm;
+}
+
+void DS3231::siftAlarmUp(uint8_t index) {
+    AlarmTableEntry entry = alarmTable[index];
+    while(index > 0){
+        uint8_t parent = (index - 1) / 2;
+        if(alarmTable[parent].next <= entry.next)
+            break;
+        alarmTable[index] = alarmTable[parent];
+        index = parent;
+    }
+    alarmTable[index] = entry;
+}
+
+void DS3231::siftAlarmDown(uint8_t index) {
+    AlarmTableEntry entry = alarmTable[index];
+    while(true){
+        uint8_t child = 2 * index + 1;
+        if(child >= alarmTableCount)
+            break;
+        if(child + 1 < alarmTableCount && alarmTable[child + 1].next < alarmTable[child].next)
+            child++;
+        if(entry.next <= alarmTable[child].next)
+            break;
+        alarmTable[index] = alarmTable[child];
+        index = child;
+    }
+    alarmTable[index] = entry;
+}
+
+/**
+ * @details Floyd's construction: sifting down from the last parent to the root takes O(n) instead of O(n log n)
+ * for n insertions.
+ */
+void DS3231::heapifyAlarmTable() {
+    for(uint8_t i = alarmTableCount / 2; i-- > 0;)
+        siftAlarmDown(i);
+}
+
+/**
+ * @details The next time of an alarm is at most a week away, so date, hour, minutes and seconds match it only once.
+ * The registers cannot hold the month: a time already past is never matched, advanceAlarmTable() takes it.
+ * An empty table gives the registers back to the alarm 1 of the user kept since the first alarm was added; its
+ * enable bit is written here rather than by toggleAlarm(), which would also clear a pending alarm 2 flag.
+ */
+void DS3231::programAlarmTable() {
+    if(alarmTableCount == 0){
+        if(userAlarm1.day == DAILY)
+            DS3231::setAlarmDaily(1, userAlarm1.hour, userAlarm1.minutes);
+        else
+            DS3231::setAlarmWeekly(1, userAlarm1.hour, userAlarm1.minutes, userAlarm1.day);
+        alarm1.pm = alarm1.hour >= 12;
+        alarm1.enabled = userAlarm1.enabled;
+        uint8_t control = DS3231::readControl();
+        if(alarm1.enabled){
+            control = DS3231::setHigh(control, BIT_A1IE);
+            if(!softClock){
+                control = DS3231::setHigh(control, BIT_INTCN);
+                INTCtr = true;
+            }
+        }
+        else
+            control = DS3231::setLow(control, BIT_A1IE);
+        DS3231::writeControl(control);
+        return;
+    }
+    uint8_t control = DS3231::readControl();
+    RTCdata next = alarmTable[0].next;
+    uint8_t bytes[4];
+    // every mask bit 0, DY/DT 0 -> the alarm matches date, hour, minutes and seconds
+    bytes[0] = DS3231::DECtoBCD(next.seconds());
+    bytes[1] = DS3231::DECtoBCD(next.minutes());
+    bytes[2] = DS3231::DECtoBCD(next.hour());
+    bytes[3] = DS3231::DECtoBCD(next.date());
+    DS3231::writeRegister(REG_ALARM1_SEC, bytes, 4);
+    // a date match alarm reads as DAILY (see RTCsnapshot)
+    alarm1.seconds = next.seconds();
+    alarm1.minutes = next.minutes();
+    alarm1.hour = next.hour();
+    alarm1.day = DAILY;
+    alarm1.pm = next.pm();
+    alarm1.enabled = true;
+    control = DS3231::setHigh(control, BIT_A1IE);
+    if(!softClock){
+        control = DS3231::setHigh(control, BIT_INTCN);
+        INTCtr = true;
+    }
+    DS3231::writeControl(control);
+}
+
+/**
+ * @details The records are read a page at a time and the heap is built bottom up. Only begin() reads the records:
+ * a new time is handled by rescheduleAlarmTable() from RAM.
+ */
+void DS3231::readAlarmTable() {
+    if(alarmTableCount == 0)
+        userAlarm1 = alarm1; // the registers still hold the alarm of the user
+    alarmTableCount = 0;
+    RTCepoch now = clockTime.epoch();
+    uint8_t records[EEPROM_PAGE_SIZE];
+    const uint8_t perPage = EEPROM_PAGE_SIZE / ALARM_TABLE_RECORD;
+    for(uint8_t first = 0; first < ALARM_TABLE_ENTRIES; first += perPage){
+        uint8_t slots = ALARM_TABLE_ENTRIES - first < perPage ? ALARM_TABLE_ENTRIES - first : perPage;
+        if(readEEPROM(ALARM_TABLE_START + first * ALARM_TABLE_RECORD, records, slots * ALARM_TABLE_RECORD) != BUS_OK)
+            continue; // these alarms are missing until the next read
+        for(uint8_t i = 0; i < slots; i++){
+            RTCalarm alarm;
+            if(!DS3231::decodeTableRecord(records + i * ALARM_TABLE_RECORD, alarm))
+                continue;
+            AlarmTableEntry& entry = alarmTable[alarmTableCount++];
+            entry.next = RTCdata::fromEpoch(DS3231::nextOccurrence(now, alarm));
+            entry.slot = first + i;
+            entry.weekly = alarm.day != DAILY;
+        }
+    }
+    heapifyAlarmTable();
+    if(alarmTableCount)
+        programAlarmTable();
+}
+
+/**
+ * @details The free slot is the lowest one no entry of the heap uses, found with a bit mask in one pass.
+ */
+uint8_t DS3231::addTableAlarm(const RTCalarm& alarm) {
+    DS3231_STAT(STAT_ALARM_TABLE);
+    if(alarmTableCount == ALARM_TABLE_ENTRIES)
+        return ALARM_TABLE_NONE;
+    uint64_t used = 0;
+    for(uint8_t i = 0; i < alarmTableCount; i++)
+        used |= 1ULL << alarmTable[i].slot;
+    uint8_t slot = 0;
+    while(used >> slot & 1)
+        slot++;
+    RTCalarm stored = alarm;
+    stored.day = (dayOfWeek)(alarm.day % 8);
+    stored.hour = alarm.hour % 24;
+    stored.minutes = alarm.minutes % 60;
+    stored.seconds = alarm.seconds % 60;
+    uint8_t record[ALARM_TABLE_RECORD] = {(uint8_t)stored.day, stored.hour, stored.minutes, stored.seconds};
+    writeEEPROM(ALARM_TABLE_START + slot * ALARM_TABLE_RECORD, record, ALARM_TABLE_RECORD);
+    RTCdata now = DS3231::currentTime();
+    if(alarmTableCount == 0)
+        userAlarm1 = alarm1; // kept until the table empties again
+    uint8_t index = alarmTableCount++;
+    alarmTable[index].next = RTCdata::fromEpoch(DS3231::nextOccurrence(now.epoch(), stored));
+    alarmTable[index].slot = slot;
+    alarmTable[index].weekly = stored.day != DAILY;
+    siftAlarmUp(index);
+    if(alarmTable[0].slot == slot)
+        programAlarmTable(); // it rings first
+    return slot;
+}
+
+bool DS3231::removeTableAlarm(uint8_t slot) {
+    DS3231_STAT(STAT_ALARM_TABLE);
+    uint8_t index = 0;
+    while(index < alarmTableCount && alarmTable[index].slot != slot)
+        index++;
+    if(index == alarmTableCount)
+        return false;
+    uint8_t record[ALARM_TABLE_RECORD];
+    memset(record, 0xFF, sizeof(record));
+    writeEEPROM(ALARM_TABLE_START + slot * ALARM_TABLE_RECORD, record, ALARM_TABLE_RECORD);
+    // the last entry takes the place of the removed one and moves up or down from there
+    alarmTableCount--;
+    if(index < alarmTableCount){
+        alarmTable[index] = alarmTable[alarmTableCount];
+        siftAlarmUp(index);
+        siftAlarmDown(index);
+    }
+    if(index == 0)
+        programAlarmTable(); // another alarm rings first now, or none
+    return true;
+}
+
+RTCalarm DS3231::readTableAlarm(uint8_t slot) {
+    DS3231_STAT(STAT_ALARM_TABLE);
+    RTCalarm alarm = {0, 0, 0, DAILY, false, false};
+    uint8_t record[ALARM_TABLE_RECORD];
+    if(slot >= ALARM_TABLE_ENTRIES ||
+       readEEPROM(ALARM_TABLE_START + slot * ALARM_TABLE_RECORD, record, ALARM_TABLE_RECORD) != BUS_OK)
+        return alarm;
+    DS3231::decodeTableRecord(record, alarm);
+    return alarm;
+}
+
+uint8_t DS3231::nextTableAlarm(RTCdata& when) const {
+    if(alarmTableCount == 0)
+        return ALARM_TABLE_NONE;
+    when = alarmTable[0].next;
+    return alarmTable[0].slot;
+}
+
+/**
+ * @details Only the root changes: it gets its next time and sinks to its place, then the new root is programmed.
+ * The record is read from the EEPROM (one 4 byte read) instead of being kept in RAM for every alarm.
+ */
+uint8_t DS3231::advanceAlarmTable() {
+    DS3231_STAT(STAT_ALARM_TABLE);
+    if(alarmTableCount == 0)
+        return ALARM_TABLE_NONE;
+    RTCdata now = DS3231::currentTime();
+    if(now < alarmTable[0].next)
+        return ALARM_TABLE_NONE;
+    uint8_t slot = alarmTable[0].slot;
+    RTCalarm alarm = readTableAlarm(slot);
+    if(!alarm.enabled)
+        return ALARM_TABLE_NONE;
+    alarmTable[0].next = RTCdata::fromEpoch(DS3231::nextOccurrence(now.epoch(), alarm));
+    siftAlarmDown(0);
+    // A1F written 0 (cleared), A2F and OSF written 1 (left unchanged)
+    DS3231::writeStatus(DS3231::setLow(DS3231::readStatus() | STATUS_CLEAR_ONLY, BIT_A1F));
+    softAlarmFlags &= ~0x01;
+    programAlarmTable();
+    return slot;
+}
+#endif
+
 /*--------------------------------------------------------------------------------------------------------------------
  *                                              TEMPERATURE
 ---------------------------------------------------------------------------------------------------------------------*/
 
 
-float DS3231::readCelcius() {
-    float temperature, floatTemp;
+int16_t DS3231::readQuarterCelcius() {
+    DS3231_STAT(STAT_TEMPERATURE);
     uint8_t bytes[2];
-    DS3231::readRegister(REG_TEMP_INT,bytes,2);
-    temperature = bytes[0];
-    bytes[1] >>= 6;
-    floatTemp = bytes[1]*0.25;
-    if(temperature >= 0)
-        temperature += floatTemp;
-    else
-        temperature -= floatTemp;
+    if(DS3231::readRegister(REG_TEMP_INT,bytes,2) != BUS_OK)
+        return lastSample;
+    return DS3231::decodeTemperature(bytes[0], bytes[1]);
+}
+
+float DS3231::readCelcius() {
+    DS3231_STAT(STAT_TEMPERATURE);
+    return DS3231::toCelcius(DS3231::readQuarterCelcius());
+}
+
+/**
+ * @details The upper byte is the signed integer part, bits 7 and 6 of the lower byte are the fraction;
+ * together they are a 10 bit two's complement number of quarter degrees.
+ */
+int16_t DS3231::decodeTemperature(uint8_t msb, uint8_t lsb) {
+    return (int16_t)((int8_t)msb) * 4 + (lsb >> 6);
+}
 
-    return temperature;
+float DS3231::toCelcius(int16_t quarterDegrees) {
+    return quarterDegrees * 0.25;
 }
 
 float DS3231::readFahrenheit() {
-    float celcius = DS3231::readCelcius();
+    DS3231_STAT(STAT_TEMPERATURE);
+    return DS3231::toFahrenheit(DS3231::readCelcius());
+}
+
+float DS3231::readKelvin() {
+    DS3231_STAT(STAT_TEMPERATURE);
+    return DS3231::toKelvin(DS3231::readCelcius());
+}
+
+float DS3231::toFahrenheit(float celcius) {
     float fahrenheit = celcius * 1.8 +32;
     return fahrenheit;
 }
 
-float DS3231::readKelvin() {
-    float celcius = DS3231::readCelcius();
+float DS3231::toKelvin(float celcius) {
     float kelvin = celcius + 273.15;
     return kelvin;
 }
 
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                          FIXED POINT TEMPERATURE
+---------------------------------------------------------------------------------------------------------------------*/
+
+int16_t DS3231::readCentiCelcius() {
+    DS3231_STAT(STAT_TEMPERATURE);
+    return DS3231::quarterToCentiCelcius(DS3231::readQuarterCelcius());
+}
+
+int16_t DS3231::readCentiFahrenheit() {
+    DS3231_STAT(STAT_TEMPERATURE);
+    return DS3231::quarterToCentiFahrenheit(DS3231::readQuarterCelcius());
+}
+
+uint16_t DS3231::readCentiKelvin() {
+    DS3231_STAT(STAT_TEMPERATURE);
+    return DS3231::quarterToCentiKelvin(DS3231::readQuarterCelcius());
+}
+
+int16_t DS3231::quarterToCentiCelcius(int16_t quarterDegrees) {
+    return quarterDegrees * 25;
+}
+
+// F = C * 9 / 5 + 32  ->  100 * F = 25 * q * 9 / 5 + 3200 = 45 * q + 3200
+int16_t DS3231::quarterToCentiFahrenheit(int16_t quarterDegrees) {
+    return quarterDegrees * 45 + 3200;
+}
+
+uint16_t DS3231::quarterToCentiKelvin(int16_t quarterDegrees) {
+    return (uint16_t)(quarterDegrees * 25 + 27315);
+}
+
+/**
+ * @details The digits are found by subtracting powers of ten, so no division (a library call on the AVR) is needed.
+ * Values up to +-99999.99 are supported.
+ */
+uint8_t DS3231::formatCenti(int32_t centi, char buffer[]) {
+    static const uint32_t powers[] = {1000000, 100000, 10000, 1000, 100, 10, 1};
+    uint8_t length = 0;
+    uint32_t value;
+    if(centi < 0){
+        buffer[length++] = '-';
+        value = (uint32_t)(-centi);
+    }
+    else value = (uint32_t)centi;
+    bool leading = true;
+    for(uint8_t i = 0; i < 7; i++){
+        char digit = '0';
+        while(value >= powers[i]){
+            value -= powers[i];
+            digit++;
+        }
+        if(i == 5)
+            buffer[length++] = '.';
+        // the units digit (i == 4) is always printed
+        if(leading && digit == '0' && i < 4)
+            continue;
+        leading = false;
+        buffer[length++] = digit;
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
 /*--------------------------------------------------------------------------------------------------------------------
  *                                              CONTROL SQW
 ---------------------------------------------------------------------------------------------------------------------*/
 
 void DS3231::toggleSQW(bool enable) {
-     uint8_t byte[1];
-     DS3231::readRegister(REG_CONTROL,byte,1);
-     INTCtr = enable; // when 0 SQW is on
+    DS3231_STAT(STAT_OUTPUTS);
+     uint8_t control = DS3231::readControl();
+     INTCtr = !enable; // when 0 SQW is on
      if(enable)
-         byte[0] = DS3231::setLow(byte[0],2);
+         control = DS3231::setLow(control, BIT_INTCN);
      else
-         byte[0] = DS3231::setHigh(byte[0],2);
-     DS3231::writeRegister(REG_CONTROL,byte,1);
+         control = DS3231::setHigh(control, BIT_INTCN);
+     DS3231::writeControl(control);
  }
 
  // this method sets the freq of SWQ but does not toggle it on of off
@@ -758,53 +2021,55 @@ void DS3231::toggleSQW(bool enable) {
   *         1                    1                    8.192kHz
   */
  void DS3231::setSQW(uint8_t mode) { //0 : 1Hz, 1 : 1kHz, 2: 4kHz, 3 : 8kHz
-    uint8_t byte[1];
-    DS3231::readRegister(REG_CONTROL,byte,1);
+    DS3231_STAT(STAT_OUTPUTS);
+    uint8_t control = DS3231::readControl();
     //of interest: bit 4 and bit 3
      switch (mode) {
          case 0:
-             byte[0] = DS3231::setLow(byte[0],3);
-             byte[0] = DS3231::setLow(byte[0],4);
+             control = DS3231::setLow(control, BIT_RS1);
+             control = DS3231::setLow(control, BIT_RS2);
              break;
          case 1:
-             byte[0] = DS3231::setHigh(byte[0],3);
-             byte[0] = DS3231::setLow(byte[0],4);
+             control = DS3231::setHigh(control, BIT_RS1);
+             control = DS3231::setLow(control, BIT_RS2);
              break;
          case 2:
-             byte[0] = DS3231::setLow(byte[0],3);
-             byte[0] = DS3231::setHigh(byte[0],4);
+             control = DS3231::setLow(control, BIT_RS1);
+             control = DS3231::setHigh(control, BIT_RS2);
              break;
          case 3:
-             byte[0] = DS3231::setHigh(byte[0],3);
-             byte[0] = DS3231::setHigh(byte[0],4);
+             control = DS3231::setHigh(control, BIT_RS1);
+             control = DS3231::setHigh(control, BIT_RS2);
              break;
      }
-     DS3231::writeRegister(REG_CONTROL,byte,1);
+     DS3231::writeControl(control);
 }
 
 //this method toggles the 32KHz pin
 //status register bit3
 void DS3231::toggle32kHz(bool enable) {
-     uint8_t byte[1];
-     DS3231::readRegister(REG_STATUS, byte,1);
+    DS3231_STAT(STAT_OUTPUTS);
+     uint8_t status = DS3231::readStatus();
      if(enable)
-         byte[0] = DS3231::setHigh(byte[0],3);
+         status = DS3231::setHigh(status, BIT_EN32KHZ);
      else
-         byte[0] = DS3231::setLow(byte[0], 3);
-
-     DS3231::writeRegister(REG_STATUS,byte,1);
+         status = DS3231::setLow(status, BIT_EN32KHZ);
+     if(status == statusShadow)
+         return; // already in the requested state
+     // the flag bits are written as 1 so the device leaves them unchanged
+     DS3231::writeStatus(status | STATUS_CLEAR_ONLY);
  }
 
  //the oscillator can stop only if DS3231 is powered by the battery.
  // 1 -> turned off ; 0 -> turned on;
  void DS3231::enableOSC(bool enable) {
-     uint8_t byte[1];
-     DS3231::readRegister(REG_CONTROL, byte, 1);
+     DS3231_STAT(STAT_OUTPUTS);
+     uint8_t control = DS3231::readControl();
      if(enable)
-        byte[0] = DS3231::setLow(byte[0], 7);
+        control = DS3231::setLow(control, BIT_EOSC);
      else
-         byte[0] = DS3231::setHigh(byte[0], 7);
-     DS3231::writeRegister(REG_CONTROL, byte, 1);
+         control = DS3231::setHigh(control, BIT_EOSC);
+     DS3231::writeControl(control);
  }
 
 
@@ -812,18 +2077,215 @@ void DS3231::toggle32kHz(bool enable) {
 *                                              TEMPERATURE DATA
 ---------------------------------------------------------------------------------------------------------------------*/
 
-void DS3231::storeTemperature(void) {
-    writeEEPROM(TEMPERATURE_ADDRESS, (uint8_t*)last24hTemperature, 24*sizeof(float));
+// sign extends a 10 bit two's complement value
+static int16_t signExtend10(uint16_t value) {
+    return (value & 0x0200) ? (int16_t)value - 0x0400 : (int16_t)value;
+}
+
+uint16_t DS3231::logStart(TempTier tier) {
+    switch(tier){
+        case TIER_DAY: return TEMP_LOG_DAY_START;
+        case TIER_WEEK: return TEMP_LOG_WEEK_START;
+        default: return TEMP_LOG_START;
+    }
 }
 
+uint16_t DS3231::logSlots(TempTier tier) {
+    switch(tier){
+        case TIER_DAY: return TEMP_LOG_DAY_SLOTS;
+        case TIER_WEEK: return TEMP_LOG_WEEK_SLOTS;
+        default: return TEMP_LOG_HOUR_SLOTS;
+    }
+}
+
+uint16_t DS3231::logWritten(TempTier tier) const {
+    uint8_t log = tier - TIER_HOUR;
+    return logHead[log] == TEMP_LOG_NONE ? 0 : logSeq[log] + 1;
+}
+
+/**
+ * @details The three logs are recovered separately. The period each tier was collecting is not logged: it is made
+ * of the periods of the tier below logged after the newest record of the tier, and their number follows from the
+ * record counts (24 hour records per day record, 7 day records per week record). If the record closing a period
+ * was lost with the power, the period is closed again. A log written with another record layout
+ * (TEMP_LOG_VERSION) is discarded.
+ */
 void DS3231::takeStoredTemperature(void) {
-    readEEPROM(TEMPERATURE_ADDRESS, (uint8_t*)last24hTemperature, 24*sizeof(float));
+    for(uint8_t tier = TIER_MINUTE; tier <= TIER_WEEK; tier++)
+        stored[tier] = 0;
+    for(uint8_t i = 0; i < 3; i++){
+        logHead[i] = TEMP_LOG_NONE;
+        logSeq[i] = 0;
+    }
+    DS3231::clearAccumulator(currentDay);
+    DS3231::clearAccumulator(currentWeek);
+    uint8_t header[2];
+    if(readEEPROM(TEMP_LOG_HEADER, header, 2) != BUS_OK)
+        return; // starts with an empty history, the header is not rewritten
+    if(header[0] != TEMP_LOG_MAGIC || header[1] != TEMP_LOG_VERSION){
+        for(uint8_t tier = TIER_HOUR; tier <= TIER_WEEK; tier++)
+            recoverTier(TempTier(tier)); // only clears the RAM rings: no record passes the check of this version
+        header[0] = TEMP_LOG_MAGIC;
+        header[1] = TEMP_LOG_VERSION;
+        writeEEPROM(TEMP_LOG_HEADER, header, 2);
+        return;
+    }
+    for(uint8_t tier = TIER_HOUR; tier <= TIER_WEEK; tier++)
+        recoverTier(TempTier(tier));
+    // the week first: closing a lost day record adds the day to it
+    for(uint8_t tier = TIER_WEEK; tier >= TIER_DAY; tier--){
+        TempTier below = TempTier(tier - 1);
+        uint8_t periods = DS3231::tierPeriods(TempTier(tier));
+        // counted modulo 65536 like the sequence numbers
+        uint16_t pending = logWritten(below) - periods * logWritten(TempTier(tier));
+        if(pending > periods)
+            pending = 0; // the logs do not belong together
+        if(pending > stored[below])
+            pending = stored[below];
+        uint8_t size;
+        uint8_t* head;
+        TempAggregate* ring = tierRing(below, size, head);
+        TempAccumulator& accumulator = tierAccumulator(TempTier(tier));
+        for(uint8_t i = pending; i > 0; i--)
+            DS3231::accumulate(accumulator, ring[(*head + size - (i - 1)) % size]);
+        if(accumulator.count == periods){
+            TempAggregate period = DS3231::aggregate(accumulator);
+            DS3231::clearAccumulator(accumulator);
+            closePeriod(TempTier(tier), period);
+        }
+    }
+}
+
+/**
+ * @details The slots hold consecutive sequence numbers from slot 0 up to the newest record; the slots after it are
+ * empty or hold records of the previous round. The newest record is found with a binary search on that
+ * property, then the records before it are read: at most log2(logSlots(tier)) + 24 record reads.
+ */
+void DS3231::recoverTier(TempTier tier) {
+    uint8_t size;
+    uint8_t* head;
+    TempAggregate* ring = tierRing(tier, size, head);
+    for(uint8_t i = 0; i < size; i++)
+        ring[i] = {0, 0, 0};
+    *head = size - 1; // the i-th newest record goes to slot size - 1 - i
+    uint8_t log = tier - TIER_HOUR;
+    uint16_t slots = DS3231::logSlots(tier);
+    uint16_t firstSeq, seq;
+    TempAggregate aggregate;
+    if(!readLogRecord(tier, 0, firstSeq, aggregate))
+        return; // empty log
+    uint16_t low = 0, high = slots - 1;
+    while(low < high){
+        uint16_t middle = high - (high - low) / 2;
+        if(readLogRecord(tier, middle, seq, aggregate) && (uint16_t)(seq - firstSeq) == middle)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    logHead[log] = low;
+    logSeq[log] = firstSeq + low;
+    uint16_t slot = low;
+    for(uint8_t i = 0; i < size; i++){
+        if(!readLogRecord(tier, slot, seq, aggregate) || seq != (uint16_t)(logSeq[log] - i))
+            break; // fewer periods were logged
+        ring[*head - i] = aggregate;
+        stored[tier]++;
+        slot = slot ? slot - 1 : slots - 1;
+    }
+}
+
+uint8_t DS3231::readTemperatureHistory(TempTier tier, TempAggregate* temperatures, uint8_t count) {
+    if(count > stored[tier])
+        count = stored[tier];
+    if(tier == TIER_MINUTE){
+        for(uint8_t i = 0; i < count; i++){
+            int16_t sample = last1hTemperature[(timeKeep + TEMP_HISTORY_MINUTES - 1 - i) % TEMP_HISTORY_MINUTES];
+            temperatures[i] = {sample, sample, sample};
+        }
+        return count;
+    }
+    uint8_t size;
+    uint8_t* head;
+    TempAggregate* ring = tierRing(tier, size, head);
+    for(uint8_t i = 0; i < count; i++)
+        temperatures[i] = ring[(*head + size - i) % size];
+    return count;
+}
+
+void DS3231::readLast24hTemperature(int16_t* temperatures) {
+    // the RAM copy matches the newest records of the log, unless writeDummyTemperatures() replaced it
+    for(uint8_t i = 0; i < 24; i++)
+        temperatures[i] = last24hTemperature[(hourHead + 24 - i) % 24].mean;
 }
 
 void DS3231::readLast24hTemperature(float* temperatures) {
-    readEEPROM(TEMPERATURE_ADDRESS, (uint8_t*)temperatures, 24*sizeof(float));
+    for(uint8_t i = 0; i < 24; i++)
+        temperatures[i] = DS3231::toCelcius(last24hTemperature[(hourHead + 24 - i) % 24].mean);
 }
 
+/**
+ * @details Only the RAM ring of the hour tier is replaced: nothing is appended to the hour log and the day being
+ * collected is left alone, so takeStoredTemperature() brings back the measured hours after a reset.
+ */
 void DS3231::writeDummyTemperatures(float* temperatures) {
-    writeEEPROM(TEMPERATURE_ADDRESS, (uint8_t*)temperatures, 24*sizeof(float));
-}
\ No newline at end of file
+    for(uint8_t i = 0; i < TEMP_HISTORY_HOURS; i++){
+        // rounded to the nearest quarter degree
+        float quarters = temperatures[i] * 4;
+        int16_t temperature = (int16_t)(quarters >= 0 ? quarters + 0.5 : quarters - 0.5);
+        last24hTemperature[(hourHead + TEMP_HISTORY_HOURS - i) % TEMP_HISTORY_HOURS] = {temperature, temperature,
+                                                                                        temperature};
+    }
+    stored[TIER_HOUR] = TEMP_HISTORY_HOURS;
+}
+
+/**
+ * @details Record layout (little endian): bytes 0-1 -> sequence number; bytes 2-5 -> bits 0-9 mean, bits 10-19 min,
+ * bits 20-29 max in 0.25 Celcius steps (two's complement, -128 to 127.75), bits 30-31 tier; bytes 6-7 -> check.
+ * Erased (0xFF) slots fail the check.
+ */
+bool DS3231::readLogRecord(TempTier tier, uint16_t slot, uint16_t& seq, TempAggregate& aggregate) {
+    uint8_t record[TEMP_LOG_RECORD];
+    if(readEEPROM(DS3231::logStart(tier) + slot * TEMP_LOG_RECORD, record, TEMP_LOG_RECORD) != BUS_OK)
+        return false;
+    if((record[6] | (uint16_t)record[7] << 8) != DS3231::logChecksum(record))
+        return false;
+    uint32_t packed = record[2] | (uint32_t)record[3] << 8 | (uint32_t)record[4] << 16 | (uint32_t)record[5] << 24;
+    if((packed >> 30) != tier)
+        return false;
+    seq = record[0] | (uint16_t)record[1] << 8;
+    aggregate.mean = signExtend10(packed & 0x03FF);
+    aggregate.min = signExtend10((packed >> 10) & 0x03FF);
+    aggregate.max = signExtend10((packed >> 20) & 0x03FF);
+    return true;
+}
+
+void DS3231::appendLogRecord(TempTier tier, const TempAggregate& aggregate) {
+    uint8_t log = tier - TIER_HOUR;
+    if(logHead[log] == TEMP_LOG_NONE){ // first record of an empty log
+        logHead[log] = 0;
+        logSeq[log] = 0;
+    }
+    else{
+        logHead[log] = (logHead[log] + 1) % DS3231::logSlots(tier);
+        logSeq[log]++;
+    }
+    uint32_t packed = ((uint16_t)aggregate.mean & 0x03FF) | (uint32_t)((uint16_t)aggregate.min & 0x03FF) << 10 |
+                      (uint32_t)((uint16_t)aggregate.max & 0x03FF) << 20 | (uint32_t)tier << 30;
+    uint8_t record[TEMP_LOG_RECORD];
+    record[0] = logSeq[log] & 0xFF;
+    record[1] = logSeq[log] >> 8;
+    for(uint8_t i = 0; i < 4; i++)
+        record[2 + i] = packed >> (8 * i);
+    uint16_t checksum = DS3231::logChecksum(record);
+    record[6] = checksum & 0xFF;
+    record[7] = checksum >> 8;
+    writeEEPROM(DS3231::logStart(tier) + logHead[log] * TEMP_LOG_RECORD, record, TEMP_LOG_RECORD);
+}
+
+// the version is part of the check, so records of another layout are not taken as valid
+uint16_t DS3231::logChecksum(const uint8_t record[]) {
+    uint16_t checksum = 0xA55A ^ TEMP_LOG_VERSION;
+    for(uint8_t i = 0; i < 6; i++)
+        checksum = (checksum << 3 | checksum >> 13) ^ record[i];
+    return checksum;
+}
@@ -6,14 +6,79 @@
 #define DS3231_NEW_DS3231_H
 
 #include <Arduino.h>
-#include <Wire.h>
+#include "DS3231Bus.h"
 
 #define DS3231_ADDRESS 0x68
 #define EEPROM_ADDRESS 0x57
 
-#define TEMPERATURE_ADDRESS (uint16_t)(0x0000)
-#define ALARM1_ADDRESS (uint16_t)(0x1000u)
-#define ALARM2_ADDRESS (uint16_t)(0x1005u)
+/// the AT24C32 programs at most one 32 byte page per write cycle
+#define EEPROM_PAGE_SIZE 32
+/// data bytes per write transaction: what the bus transport carries minus the two address bytes, at most a page
+#define EEPROM_CHUNK_SIZE (DS3231_BUS::MAX_TRANSFER - 2 < EEPROM_PAGE_SIZE ? DS3231_BUS::MAX_TRANSFER - 2 : EEPROM_PAGE_SIZE)
+/// bytes that can wait in the EEPROM write queue
+#define EEPROM_QUEUE_SIZE 128
+/// writes that can wait in the EEPROM write queue
+#define EEPROM_QUEUE_JOBS 4
+/// longest write cycle of the AT24C32; the acknowledge polls that fail after it are retried as failures
+#define EEPROM_WRITE_TIMEOUT_MS 10
+
+/*-----------------------------------------------------------------------------
+                            * EEPROM layout (AT24C32, 4 KB, 12 bit address):
+                            * 0x0000 -> alarm 1 (5 bytes)
+                            * 0x0005 -> alarm 2 (5 bytes)
+                            * 0x0020 -> temperature log header (magic, version)
+                            * 0x0022 -> alarm table header (magic, version)
+                            * 0x0040 -> alarm table, one 4 byte record per slot,
+                            *           ALARM_TABLE_ENTRIES slots up to 0x00FF
+                            * 0x0100 -> hour tier log, one record per hour,
+                            *           written as a ring up to 0x0DFF
+                            * 0x0E00 -> day tier log, one record per day,
+                            *           written as a ring up to 0x0EFF
+                            * 0x0F00 -> week tier log, one record per week,
+                            *           written as a ring up to 0x0FFF
+ ------------------------------------------------------------------------------*/
+
+#define ALARM1_ADDRESS (uint16_t)(0x0000u)
+#define ALARM2_ADDRESS (uint16_t)(0x0005u)
+#define TEMP_LOG_HEADER (uint16_t)(0x0020u)
+#define ALARM_TABLE_HEADER (uint16_t)(0x0022u)
+#define ALARM_TABLE_START (uint16_t)(0x0040u)
+#define TEMP_LOG_START (uint16_t)(0x0100u)
+#define TEMP_LOG_DAY_START (uint16_t)(0x0E00u)
+#define TEMP_LOG_WEEK_START (uint16_t)(0x0F00u)
+#define TEMP_LOG_END (uint16_t)(0x1000u)
+/// seq (2 bytes), mean/min/max and tier (4 bytes), check (2 bytes); a power of two, so records never cross a page
+#define TEMP_LOG_RECORD 8
+#define TEMP_LOG_HOUR_SLOTS ((TEMP_LOG_DAY_START - TEMP_LOG_START) / TEMP_LOG_RECORD)
+#define TEMP_LOG_DAY_SLOTS ((TEMP_LOG_WEEK_START - TEMP_LOG_DAY_START) / TEMP_LOG_RECORD)
+#define TEMP_LOG_WEEK_SLOTS ((TEMP_LOG_END - TEMP_LOG_WEEK_START) / TEMP_LOG_RECORD)
+#define TEMP_LOG_MAGIC 0x54
+/// 1 -> 8 byte float records; 2 -> 4 byte quarter degree records; 3 -> 8 byte mean/min/max records in three tiers
+#define TEMP_LOG_VERSION 3
+/// marks an empty log
+#define TEMP_LOG_NONE 0xFFFF
+
+/// alarms the table can hold (5 bytes of RAM each); the records of 48 fill the EEPROM up to the temperature log.
+/// 0 -> no alarm table is compiled (e.g. -DALARM_TABLE_ENTRIES=32 to use it)
+#ifndef ALARM_TABLE_ENTRIES
+#define ALARM_TABLE_ENTRIES 0
+#endif
+/// day (0xFF -> free slot), hour, minutes, seconds; a power of two, so records never cross a page
+#define ALARM_TABLE_RECORD 4
+#define ALARM_TABLE_END (uint16_t)(ALARM_TABLE_START + ALARM_TABLE_ENTRIES * ALARM_TABLE_RECORD)
+#define ALARM_TABLE_MAGIC 0x41
+#define ALARM_TABLE_VERSION 1
+/// no slot of the alarm table
+#define ALARM_TABLE_NONE 0xFF
+
+static_assert(ALARM_TABLE_END <= TEMP_LOG_START, "the alarm table must end before the temperature log");
+static_assert(ALARM_TABLE_ENTRIES <= 64, "the free slots of the alarm table are found with a 64 bit mask");
+
+/// closed periods kept in RAM by each tier of the temperature history
+#define TEMP_HISTORY_MINUTES 60
+#define TEMP_HISTORY_HOURS 24
+#define TEMP_HISTORY_DAYS 7
+#define TEMP_HISTORY_WEEKS 4
 
 /*-----------------------------------------------------------------------------
                             * 0x00 -> seconds
@@ -52,9 +117,44 @@
 
 #define REG_CONTROL 0x0E
 #define REG_STATUS 0x0F
+#define REG_AGING 0x10
 #define REG_TEMP_INT 0x11
 #define REG_TEMP_FLOAT 0x12
+/// number of registers of the device (0x00 - 0x12)
+#define REG_COUNT 0x13
+
+/*-----------------------------------------------------------------------------
+                            * Control register (0x0E) bits:
+                            * EOSC BBSQW CONV RS2 RS1 INTCN A2IE A1IE
+                            * Status register (0x0F) bits:
+                            * OSF 0 0 0 EN32kHz BSY A2F A1F
+ ------------------------------------------------------------------------------*/
+
+#define BIT_EOSC 7
+#define BIT_RS2 4
+#define BIT_RS1 3
+#define BIT_INTCN 2
+#define BIT_A2IE 1
+#define BIT_A1IE 0
+
+#define BIT_OSF 7
+#define BIT_EN32KHZ 3
+#define BIT_BSY 2
+#define BIT_A2F 1
+#define BIT_A1F 0
 
+/// status bits the chip changes by itself; they are never trusted from the shadow copy
+#define STATUS_VOLATILE 0b10000111
+/// status bits that can only be cleared; writing 1 leaves them unchanged
+#define STATUS_CLEAR_ONLY 0b10000011
+
+/// seconds since 2000-01-01 00:00:00 (a Saturday); 32 bits would reach 2136, RTCdata stops at RTC_DAYS_MAX
+typedef uint32_t RTCepoch;
+
+#define EPOCH_MINUTE 60UL
+#define EPOCH_HOUR 3600UL
+#define EPOCH_DAY 86400UL
+#define EPOCH_WEEK 604800UL
 
 enum dayOfWeek : uint8_t{
     DAILY = 0,
@@ -82,34 +182,59 @@ enum Month : uint8_t{
     DECEMBER = 12
 };
 
-/// @brief Struct that holds time & date information of main registers.
+/// whole years an RTCdata can hold (15 bits of days reach 2089-09-17); setDate() clamps the year to them
+#define RTC_YEAR_MIN 2000
+#define RTC_YEAR_MAX 2088
+/// last day an RTCdata can hold, 2089-09-17; later times read from the chip or given as an epoch saturate to it
+#define RTC_DAYS_MAX 0x7FFF
+
+/**
+ * @brief Struct that holds time & date information of main registers, packed in 4 bytes.
+ *
+ * Bits 17-31 -> days since 2000-01-01, bits 6-16 -> minute of the day, bits 0-5 -> seconds. The fields are in
+ * order of significance, so two times compare as integers. The hour is always kept in 24 hour format and the day
+ * of week follows from the date. Trivially copyable: a copy is a 32 bit move.
+ */
 struct RTCdata{
-    uint8_t seconds;
-    uint8_t minutes;
-    uint8_t hour;
-    dayOfWeek day;
-    Month month;
-    uint16_t year;
-    uint8_t date;
-    bool pm;
-    bool operator == (RTCdata clock){
-        return (this->seconds == clock.seconds && this->minutes == clock.minutes && this->hour == clock.hour &&
-                this->day == clock.day && this->month == clock.month && this->year == clock.year &&
-                this->date == clock.date);
-    }
-    RTCdata operator = (const RTCdata& clock){
-        this->seconds = clock.seconds;
-        this->minutes = clock.minutes;
-        this->hour = clock.hour;
-        this->date = clock.date;
-        this->day = clock.day;
-        this->month = clock.month;
-        this->year = clock.year;
-
-        return *this;
+    uint32_t packed;
+
+    uint8_t seconds() const { return packed & 0x3F; }
+    /// minutes since midnight (0 - 1439)
+    uint16_t minuteOfDay() const { return (packed >> 6) & 0x07FF; }
+    uint8_t minutes() const { return minuteOfDay() % 60; }
+    /// hour in 24 hour format (0 - 23)
+    uint8_t hour() const { return minuteOfDay() / 60; }
+    /// hour in 12 hour format (1 - 12), see pm()
+    uint8_t hour12() const { return (hour() + 11) % 12 + 1; }
+    bool pm() const { return minuteOfDay() >= 12 * 60; }
+    /// days since 2000-01-01
+    uint16_t days() const { return packed >> 17; }
+    dayOfWeek day() const;
+    uint8_t date() const;
+    Month month() const;
+    uint16_t year() const;
+    /// seconds since 2000-01-01 00:00:00
+    RTCepoch epoch() const;
+
+    /// Builds an RTCdata from days since 2000-01-01, minutes since midnight and seconds.
+    static RTCdata fromDays(uint16_t days, uint16_t minuteOfDay, uint8_t seconds) {
+        return RTCdata{(uint32_t)days << 17 | (uint32_t)minuteOfDay << 6 | seconds};
     }
+    /// Builds an RTCdata from a date (RTC_YEAR_MIN - RTC_YEAR_MAX) and a time in 24 hour format.
+    static RTCdata make(uint16_t year, uint8_t month, uint8_t date, uint8_t hour, uint8_t minutes, uint8_t seconds);
+    /// Builds an RTCdata from seconds since 2000-01-01 00:00:00; saturates at the end of RTC_DAYS_MAX.
+    static RTCdata fromEpoch(RTCepoch epoch);
+
+    bool operator == (const RTCdata& other) const { return packed == other.packed; }
+    bool operator != (const RTCdata& other) const { return packed != other.packed; }
+    bool operator < (const RTCdata& other) const { return packed < other.packed; }
+    bool operator <= (const RTCdata& other) const { return packed <= other.packed; }
+    bool operator > (const RTCdata& other) const { return packed > other.packed; }
+    bool operator >= (const RTCdata& other) const { return packed >= other.packed; }
 };
 
+static_assert(sizeof(RTCdata) == 4, "RTCdata must stay packed in 4 bytes");
+
 
 /// @brief Struct that holds values for alarm time and day registers.
 struct RTCalarm{
@@ -119,15 +244,163 @@ struct RTCalarm{
     dayOfWeek day;
     bool enabled;
     bool pm;
-    RTCalarm operator = (const RTCalarm& alarm) {
-        this->seconds = alarm.seconds;
-        this->minutes = alarm.minutes;
-        this->hour = alarm.hour;
-        this->day = alarm.day;
-        this->enabled = alarm.enabled;
-
-        return *this;
-    }
+};
+
+/// @brief One alarm of the alarm table in RAM: when it rings next and where its record is.
+struct AlarmTableEntry{
+    RTCdata next;
+    /// the record of the alarm in the EEPROM (0 - ALARM_TABLE_ENTRIES - 1)
+    uint8_t slot : 7;
+    /// 1 -> the alarm rings on the day of the week of next only; 0 -> every day
+    uint8_t weekly : 1;
+};
+
+/// @brief Struct that holds a decoded copy of the whole register file (0x00 - 0x12).
+struct RTCsnapshot{
+    /// time & date registers (0x00 - 0x06)
+    RTCdata time;
+    /// alarm 1 registers (0x07 - 0x0A); enabled is taken from A1IE. A date match alarm reads as DAILY.
+    RTCalarm alarm1;
+    /// alarm 2 registers (0x0B - 0x0D); enabled is taken from A2IE. A date match alarm reads as DAILY.
+    RTCalarm alarm2;
+    /// raw control register (0x0E)
+    uint8_t control;
+    /// raw status register (0x0F)
+    uint8_t status;
+    /// aging offset register (0x10)
+    int8_t aging;
+    /// temperature registers (0x11 - 0x12) in 0.25 Celcius steps
+    int16_t temperature;
+};
+
+/// @brief Resolution of a tier of the temperature history.
+enum TempTier : uint8_t{
+    TIER_MINUTE = 0,
+    TIER_HOUR = 1,
+    TIER_DAY = 2,
+    TIER_WEEK = 3
+};
+
+/// @brief Mean, minimum and maximum temperature of one period, in 0.25 Celcius steps.
+struct TempAggregate{
+    int16_t mean;
+    int16_t min;
+    int16_t max;
+};
+
+/// @brief Running statistics of the period a tier is currently collecting.
+struct TempAccumulator{
+    /// sum of the means of the closed periods of the tier below
+    int32_t sum;
+    int16_t min;
+    int16_t max;
+    /// closed periods of the tier below collected so far
+    uint8_t count;
+};
+
+/// @brief Result of a bus transaction: the codes of Wire's endTransmission() plus short reads.
+enum BusStatus : uint8_t{
+    BUS_OK = 0,
+    /// the write did not fit the buffer of the bus transport
+    BUS_TOO_LONG = 1,
+    BUS_NACK_ADDRESS = 2,
+    BUS_NACK_DATA = 3,
+    BUS_ERROR = 4,
+    /// the device sent fewer bytes than requested
+    BUS_SHORT_READ = 5
+};
+
+/// @brief Failure counters of one device on the bus (they wrap around).
+struct BusCounters{
+    /// address or data bytes not acknowledged
+    uint16_t nacks;
+    /// reads that returned fewer bytes than requested
+    uint16_t shortReads;
+    /// transactions repeated after a failure
+    uint16_t retries;
+    /// transactions that still failed after the last retry
+    uint16_t failures;
+};
+
+/// 1 -> every public call that uses the bus is measured (see dumpStats()); 0 -> no instrumentation is compiled
+#ifndef DS3231_STATS
+#define DS3231_STATS 0
+#endif
+
+#if DS3231_STATS
+/// @brief Public calls measured by the stats table; overloads and variants share an entry.
+enum DS3231Method : uint8_t{
+    STAT_BEGIN,
+    /// is_12(), set_12(), set_24()
+    STAT_HOUR_MODE,
+    STAT_SET_TIME,
+    STAT_SET_DATE,
+    /// readTime(), readEpoch()
+    STAT_READ_TIME,
+    STAT_READ_SNAPSHOT,
+    /// softTime(), softEpoch(), alarmPending()
+    STAT_SOFT_TIME,
+    /// beginSoftClock(), endSoftClock()
+    STAT_SOFT_CLOCK,
+    STAT_CHECK_ALARM_FLAG,
+    /// setAlarm(), setAlarmDaily(), setAlarmWeekly()
+    STAT_SET_ALARM,
+    STAT_TOGGLE_ALARM,
+    STAT_SNOOZE_ALARM,
+    /// storeAlarmEEPROM(), readAlarmEEPROM()
+    STAT_ALARM_EEPROM,
+    /// addTableAlarm(), removeTableAlarm(), readTableAlarm(), advanceAlarmTable()
+    STAT_ALARM_TABLE,
+    /// readQuarterCelcius() and the Celcius, Fahrenheit and Kelvin reads
+    STAT_TEMPERATURE,
+    /// toggleSQW(), setSQW(), toggle32kHz(), enableOSC()
+    STAT_OUTPUTS,
+    /// poll(), flushEEPROM()
+    STAT_POLL,
+    STAT_COUNT
+};
+
+/// @brief Totals of one entry of the stats table.
+struct MethodStats{
+    uint32_t calls;
+    uint32_t transactions;
+    uint32_t bytesWritten;
+    uint32_t bytesRead;
+    /// time spent in the calls, bus time and waits included
+    uint32_t micros;
+};
+
+class DS3231;
+/**
+ * @brief Measures one public call from construction to the end of the scope.
+ *
+ * Only the outermost call is recorded: the bus traffic of a public method called by another one counts for
+ * the caller.
+ */
+class DS3231StatsProbe{
+public:
+    DS3231StatsProbe(DS3231& rtc, DS3231Method method);
+    ~DS3231StatsProbe();
+private:
+    DS3231& rtc;
+    DS3231Method method;
+    BusTally start;
+    uint32_t startMicros;
+};
+#define DS3231_STAT(method) DS3231StatsProbe statsProbe(*this, method)
+#else
+#define DS3231_STAT(method)
+#endif
+
+/// retries of a failed transaction by default
+#define BUS_RETRIES 2
+/// wait before the first retry, doubled for every further one
+#define BUS_BACKOFF_MICROS 200
+
+/// @brief One write waiting in the EEPROM write queue.
+struct EEPROMJob{
+    uint16_t address;
+    uint16_t length;
 };
 
 /**
@@ -139,6 +412,17 @@ struct RTCalarm{
  */
 class DS3231 {
 private:
+    /// the bus transport, fixed at compile time (see DS3231Bus.h)
+#if DS3231_STATS
+    typedef CountingBus<DS3231_BUS> Bus;
+    friend class DS3231StatsProbe;
+    /// totals of every measured call
+    MethodStats stats[STAT_COUNT];
+    /// public calls in progress; only the outermost one is recorded
+    uint8_t statsDepth;
+#else
+    typedef DS3231_BUS Bus;
+#endif
     //Private Class Members
     /// false -> enables 32KHz SQW; true -> allows A1F & A2F to set INT/SQW pin low in alarm condition.
     bool INTCtr;
@@ -148,14 +432,81 @@ private:
     RTCalarm alarm1;
     /// holds alarm2 information.
     RTCalarm alarm2;
-    /// holds timeKeeping information
+    /// holds timeKeeping information (next slot of last1hTemperature)
     uint8_t timeKeep;
-//    /// holds temperature values from last week
-//    float lastWeekTemperature[7]{};
-    /// holds temperature values from last 24h
-    float last24hTemperature[24]{};
-    /// holds temperature values from last 1h
-    float last1hTemperature[60]{};
+    /// RAM copy of the control register (valid if shadowValid says so).
+    uint8_t controlShadow;
+    /// RAM copy of the status register; only EN32kHz is kept, the flags are volatile.
+    uint8_t statusShadow;
+    /// bit 0 -> controlShadow is valid; bit 1 -> statusShadow is valid
+    uint8_t shadowValid;
+    /// true while clockTime is advanced by the 1Hz square wave instead of being read
+    bool softClock;
+    /// square wave edges counted by tick() and not yet applied to clockTime
+    volatile uint8_t pendingTicks;
+    /// minutes between two register reads of the software clock
+    uint16_t resyncMinutes;
+    /// minutes counted by the software clock since the last register read
+    uint16_t minutesSinceSync;
+    /// forces the next softTime() call to read the registers
+    bool resyncRequested;
+    /// bit 0 -> alarm1 matched the software clock; bit 1 -> alarm2 matched
+    uint8_t softAlarmFlags;
+    /// last temperature sample (0.25 Celcius steps)
+    int16_t lastSample;
+    /// writes waiting for the EEPROM, oldest first (ring)
+    EEPROMJob eepromJobs[EEPROM_QUEUE_JOBS];
+    uint8_t jobHead;
+    uint8_t jobCount;
+    /// data of the queued writes (ring)
+    uint8_t eepromQueue[EEPROM_QUEUE_SIZE];
+    uint8_t dataHead;
+    uint8_t dataCount;
+    /// true while the EEPROM runs a write cycle it was not yet polled out of
+    bool eepromBusy;
+    /// millis() at which the running write cycle started
+    uint32_t eepromBusySince;
+    /// failed attempts to send the next chunk, or failed acknowledge polls after EEPROM_WRITE_TIMEOUT_MS
+    uint8_t eepromAttempts;
+    /// called when the queue has been written completely
+    void (*eepromCallback)();
+    /// failure counters of the DS3231 and of the EEPROM
+    BusCounters rtcCounters;
+    BusCounters eepromCounters;
+    /// retries of a failed transaction and the wait before the first one
+    uint8_t busRetries;
+    uint16_t busBackoff;
+    /// result of the last transaction
+    BusStatus lastBusStatus;
+    /// slot of the newest record of the hour, day and week logs (TEMP_LOG_NONE if the log is empty)
+    uint16_t logHead[3];
+    /// sequence number of the newest record of the hour, day and week logs
+    uint16_t logSeq[3];
+    /// minute tier: last 60 samples (0.25 Celcius steps), ring written at timeKeep
+    int16_t last1hTemperature[TEMP_HISTORY_MINUTES]{};
+    /// hour tier: last 24 hours, ring with the newest at hourHead
+    TempAggregate last24hTemperature[TEMP_HISTORY_HOURS]{};
+    /// day tier: last 7 days, ring with the newest at dayHead
+    TempAggregate lastWeekTemperature[TEMP_HISTORY_DAYS]{};
+    /// week tier: last 4 weeks, ring with the newest at weekHead
+    TempAggregate lastMonthTemperature[TEMP_HISTORY_WEEKS]{};
+    uint8_t hourHead;
+    uint8_t dayHead;
+    uint8_t weekHead;
+    /// valid entries of each tier (minute, hour, day, week)
+    uint8_t stored[4];
+    /// the hour, day and week being collected; count is the number of minutes, hours and days in it
+    TempAccumulator currentHour;
+    TempAccumulator currentDay;
+    TempAccumulator currentWeek;
+#if ALARM_TABLE_ENTRIES
+    /// alarm table: min-heap on the next time each alarm rings, the root is programmed into alarm 1
+    AlarmTableEntry alarmTable[ALARM_TABLE_ENTRIES];
+    /// the alarm 1 of the user while the table holds the registers; programmed again when the table empties
+    RTCalarm userAlarm1;
+#endif
+    /// alarms in the table; always 0 without it
+    uint8_t alarmTableCount;
 private:
     //Private Class Methods
     /**
@@ -172,44 +523,166 @@ private:
       * @return Returns the modified byte
       */
     static uint8_t setLow(uint8_t byte, uint8_t bit);
-    ///@brief Method to convert binary coded decimal to binary.
+    ///@brief Method to convert binary coded decimal to binary (branch-free, no divide).
     static uint8_t BCDtoDEC(const uint8_t bcd);
-    ///@brief Method to convert binary to binary coded decimal.
+    ///@brief Method to convert binary (0 - 99) to binary coded decimal with a table in flash.
     static uint8_t DECtoBCD(const uint8_t dec);
     /**
      * Method to read a specific register of the device.
+     *
+     * The device auto-increments its register pointer, so consecutive registers are read in one transaction.
      * @param reg The register's address
      * @param byteBuffer A byte buffer that holds the data that's being read
-     * @param bytes The number of bytes that need to be read (max 7!)
+     * @param bytes The number of bytes that need to be read (max Bus::MAX_TRANSFER, 32 with Wire)
+     * @return BUS_OK, or the error of the last attempt; byteBuffer is only complete on BUS_OK
      */
-    static void readRegister(uint8_t reg, uint8_t byteBuffer[], const uint16_t bytes);
+    BusStatus readRegister(uint8_t reg, uint8_t byteBuffer[], const uint16_t bytes);
     /**
      * Method to write data to a specific register of the device.
      * @param reg The register's address
      * @param byteBuffer A byte buffer that holds the data that's being transferred
      * @param bytes The number of bytes that need to be written (max 7!)
+     * @return BUS_OK, or the error of the last attempt
+     */
+    BusStatus writeRegister(const uint8_t reg, const uint8_t byteBuffer[], const uint8_t bytes);
+    /**
+     * Method to count the result of a transaction and to decide whether it is repeated.
+     *
+     * Waits the backoff of the attempt before returning true.
+     * @param counters The counters of the device addressed
+     * @param status The result of the attempt
+     * @param attempt The attempts made before this one
+     * @return True if the transaction has to be repeated
      */
-    static void writeRegister(const uint8_t reg, const uint8_t byteBuffer[], const uint8_t bytes);
+    bool retry(BusCounters& counters, BusStatus status, uint8_t attempt);
+    ///Method to add a failed transaction to the counters of a device.
+    static void countFailure(BusCounters& counters, BusStatus status);
     /**
      * Method to read data written to a specific address on the EEPROM chip of the device.
+     *
+     * Queued writes are completed first, so the data read is always up to date.
      * @param address The address where data is being stored
      * @param byteBuffer A byte buffer that holds the data
      * @param bytes The number of bytes that need to be read.
+     * @return BUS_OK, or the error of the first chunk that could not be read
      */
-    static void readEEPROM(uint16_t address, uint8_t byteBuffer[], const uint16_t bytes);
+    BusStatus readEEPROM(uint16_t address, uint8_t byteBuffer[], const uint16_t bytes);
     /**
-     * Method to write data to a specific address on the EEPROM chip of the device.
+     * Method to queue data for a specific address on the EEPROM chip of the device.
+     *
+     * Only waits (servicing the queue) if the queue has no room left for the data.
      * @param address address The address where data is being stored
      * @param byteBuffer A byte buffer that holds the data
      * @param bytes The number of bytes that need to be written.
+     * @return BUS_OK, or the error of the first queued write dropped while waiting for room
      */
-    static void writeEEPROM(uint16_t address, uint8_t byteBuffer[], const uint16_t bytes);
+    BusStatus writeEEPROM(uint16_t address, const uint8_t byteBuffer[], uint16_t bytes);
+    ///Method to check whether the EEPROM acknowledges its address (no write cycle running).
+    static bool probeEEPROM();
+    ///Method to drop the oldest queued write (what is left of it) after its retries failed.
+    void dropEEPROMJob();
     ///Method to toggle the INTCN bit (bit 2 of control register).
     void writeINTCtr(bool enable);
-    ///Method to store temperature vector in EEPROM
-    void storeTemperature(void);
-    ////Method to replace last24hTemperature vector with values from memory
+    ///Returns the control register, reading it from the device only if the shadow copy is not valid.
+    uint8_t readControl();
+    ///Writes the control register if the value differs from the shadow copy.
+    void writeControl(uint8_t value);
+    ///Returns the non-volatile part of the status register (EN32kHz), reading it only if needed.
+    uint8_t readStatus();
+    /**
+     * Method to write the status register.
+     *
+     * A1F, A2F and OSF bits set to 1 are left unchanged by the device, set to 0 they are cleared.
+     * @param value The byte written to the status register
+     */
+    void writeStatus(uint8_t value);
+    ///Method to decode the 7 time keeping registers into clockTime.
+    void decodeTime(const uint8_t bytes[]);
+    ///Method to encode an hour (24 hour format) for the hour register, in 12 hour mode if twelveHour is set.
+    static uint8_t encodeHour(uint8_t hour, bool twelveHour);
+    ///Method to write the day of week matching the date registers and to update the date of clockTime.
+    void syncDayOfWeek();
+    ///Method to decode 3 (alarm 1) or 4 (alarm 2) alarm registers; alarm 1 starts with the seconds register.
+    static RTCalarm decodeAlarm(const uint8_t bytes[], bool hasSeconds);
+    ///Method to encode a daily or weekly alarm as the 4 registers of alarm 1 (alarm 2 uses the last 3).
+    static void encodeAlarm(const RTCalarm& alarm, uint8_t bytes[]);
+    ///Method to convert the two temperature registers (10 bit two's complement) to 0.25 Celcius steps.
+    static int16_t decodeTemperature(uint8_t msb, uint8_t lsb);
+    ///Method to advance clockTime by one second, with minute, hour, day, month and year carries.
+    void advanceSecond();
+    ///Method to check whether an enabled alarm matches clockTime; alarm 2 has no seconds and matches at second 00.
+    bool alarmMatches(const RTCalarm& alarm, uint8_t seconds) const;
+    /**
+     * Method to check the alarm table header when starting; a table written with another record layout
+     * (ALARM_TABLE_VERSION) or never written is emptied. Does nothing without the table.
+     */
+    void takeAlarmTable();
+    ///Method to compute from clockTime when each alarm of the table rings next, after the time was set. O(n)
+    void rescheduleAlarmTable();
+    ///Methods to find the alarm 1 of the user kept in RAM while the table holds the registers; nullptr otherwise.
+    RTCalarm* keptAlarm(uint8_t alarmNumber);
+    const RTCalarm* keptAlarm(uint8_t alarmNumber) const;
+#if ALARM_TABLE_ENTRIES
+    ///Method to read the time: softTime() while the software clock runs, readTime() otherwise.
+    RTCdata currentTime();
+    ///Method to decode a record of the alarm table; false if the slot is free or holds no valid alarm.
+    static bool decodeTableRecord(const uint8_t record[], RTCalarm& alarm);
+    ///Method to rebuild the alarm of an entry of the table from its next time, without reading its record.
+    static RTCalarm tableEntryAlarm(const AlarmTableEntry& entry);
+    ///Methods to restore the heap order of the alarm table by moving the entry at index up or down. O(log n)
+    void siftAlarmUp(uint8_t index);
+    void siftAlarmDown(uint8_t index);
+    ///Method to order the whole alarm table as a heap, bottom up. O(n)
+    void heapifyAlarmTable();
+    ///Method to write the root of the alarm table into the alarm 1 registers (date match).
+    void programAlarmTable();
+    ///Method to read every record of the alarm table and compute from clockTime when each alarm rings next. O(n)
+    void readAlarmTable();
+#endif
+    ///Method to add a minute sample to the temperature history; closes the hour every 60 samples.
+    void sampleTemperature(int16_t temperature);
+    /**
+     * Method to close a period of a tier: the aggregate is added to the RAM ring and the log of the tier and
+     * counted into the period of the tier above, which is closed in turn once it is complete.
+     * @param tier TIER_HOUR, TIER_DAY or TIER_WEEK
+     * @param aggregate The statistics of the period
+     */
+    void closePeriod(TempTier tier, const TempAggregate& aggregate);
+    ///Method to add a closed period to the running statistics of a period of the tier above.
+    static void accumulate(TempAccumulator& accumulator, const TempAggregate& aggregate);
+    ///Method to compute mean, min and max of the running statistics (count must not be 0).
+    static TempAggregate aggregate(const TempAccumulator& accumulator);
+    ///Method to empty the running statistics.
+    static void clearAccumulator(TempAccumulator& accumulator);
+    ///Returns the RAM ring of TIER_HOUR, TIER_DAY or TIER_WEEK; size and head receive its size and newest slot.
+    TempAggregate* tierRing(TempTier tier, uint8_t& size, uint8_t*& head);
+    ///Returns the running statistics of the period being collected for a tier (TIER_HOUR, TIER_DAY or TIER_WEEK).
+    TempAccumulator& tierAccumulator(TempTier tier);
+    ///Returns the number of periods of the tier below making up one period of a tier.
+    static uint8_t tierPeriods(TempTier tier);
+    ///Returns the first EEPROM address of the log of TIER_HOUR, TIER_DAY or TIER_WEEK.
+    static uint16_t logStart(TempTier tier);
+    ///Returns the number of records of the log of TIER_HOUR, TIER_DAY or TIER_WEEK.
+    static uint16_t logSlots(TempTier tier);
+    ///Returns the number of records ever appended to the log of a tier (modulo 65536).
+    uint16_t logWritten(TempTier tier) const;
+    ////Method to rebuild the temperature history from the hour, day and week logs
     void takeStoredTemperature(void);
+    ///Method to find the newest record of a log and read the newest records into the RAM ring of the tier.
+    void recoverTier(TempTier tier);
+    /**
+     * Method to read one record of a temperature log.
+     * @param tier TIER_HOUR, TIER_DAY or TIER_WEEK
+     * @param slot The record number (0 - logSlots(tier)-1)
+     * @param seq Receives the sequence number of the record
+     * @param aggregate Receives the temperatures of the record
+     * @return False if the slot is empty or does not hold a valid record
+     */
+    bool readLogRecord(TempTier tier, uint16_t slot, uint16_t& seq, TempAggregate& aggregate);
+    ///Method to queue a temperature log record after the newest one.
+    void appendLogRecord(TempTier tier, const TempAggregate& aggregate);
+    ///Method to compute the 16 bit check of the first 6 bytes of a record.
+    static uint16_t logChecksum(const uint8_t record[]);
 public:
     /// By default, no SQW is outputted.
     DS3231(bool INTCtr = true);
@@ -238,24 +711,131 @@ public:
     /**
      * Method to change one item related to time (hour, minutes or seconds).
      * @param number Represents the time item. 0 -> hour, 1 -> minute, 2->seconds
-     * @param value New value of the item
+     * @param value New value of the item (the hour in 24 hour format, also in 12 hour mode)
      */
     void setTime(uint8_t number, uint8_t value);
-     ///Method to change all items related to time at once.
+     ///Method to change all items related to time at once (hours in 24 hour format, also in 12 hour mode).
     void setTime(const uint8_t hours, const uint8_t minutes, const uint8_t seconds);
     /**
-     * Method to change one item related to date (day, date, month or year).
-     * @param number Represents the date item. 0->day, 1->date, 2->month, 3->year
-     * @param value New value of the item
+     * Method to change one item related to date (date, month or year).
+     *
+     * The day of week register is rewritten to match the new date, so the weekly alarms stay correct.
+     * @param number Represents the date item. 0->day (value ignored, the day follows the date), 1->date,
+     * 2->month, 3->year
+     * @param value New value of the item; a year is clamped to RTC_YEAR_MIN - RTC_YEAR_MAX
      */
     void setDate(uint8_t number, uint16_t value);
-    ///Method to change all items related to date at once.
+    ///Method to change all items related to date at once; the day of week is computed from the date and the year is
+    ///clamped to RTC_YEAR_MIN - RTC_YEAR_MAX.
     void setDate(const dayOfWeek day, const Month month, const uint8_t date, uint16_t year);
     /**
      * Method to read the time keeping registers of the device.
+     *
+     * If the registers cannot be read (see busStatus()), the last time read is returned and no temperature
+     * sample is taken.
      * @return Returns an RTCdata object that holds the information from the registers
      */
     RTCdata readTime();
+    /**
+     * Method to read every register of the device (0x00 - 0x12) in a single I2C transaction.
+     *
+     * The time is also stored as the last read clock data and the minute temperature sample is taken
+     * from the same burst, so no other transaction is needed to refresh a display. If the registers cannot be
+     * read, the snapshot holds the last known time, alarms, registers and temperature.
+     * @return Returns an RTCsnapshot object with the decoded registers
+     */
+    RTCsnapshot readSnapshot();
+    /**
+     * Method to decode the 7 time keeping registers (0x00 - 0x06) as read from the device.
+     *
+     * Does not touch the bus; readTime() and readSnapshot() use it on the registers they read.
+     * @param bytes The registers, seconds first
+     * @return Returns an RTCdata object; a 12 hour mode register is converted to 24 hour format
+     */
+    static RTCdata decodeTimeRegisters(const uint8_t bytes[]);
+
+    /*--------------------------------------------------------------------------------------------------------------------
+     *                                   Epoch time (seconds since 2000-01-01 00:00:00)
+     ---------------------------------------------------------------------------------------------------------------------*/
+
+    /**
+     * Method to read the time keeping registers as seconds since 2000.
+     *
+     * Same bus traffic as readTime(); the same as readTime().epoch(). Two epochs compare and subtract as plain
+     * integers.
+     * @return Returns the current time as an RTCepoch
+     */
+    RTCepoch readEpoch();
+    /// Same as readEpoch(), but the time comes from softTime().
+    RTCepoch softEpoch();
+    /// Returns the number of days from 2000-01-01 to a date (RTC_YEAR_MIN - RTC_YEAR_MAX). No divide, no loop.
+    static uint16_t daysFromCivil(uint16_t year, uint8_t month, uint8_t date);
+    /// Converts a number of days since 2000-01-01 to a date.
+    static void civilFromDays(uint16_t days, uint16_t& year, uint8_t& month, uint8_t& date);
+    /// Returns the day of the week of a number of days since 2000-01-01.
+    static dayOfWeek weekday(uint16_t days);
+    /// Returns the number of days of a month (28 - 31).
+    static uint8_t daysInMonth(uint16_t year, uint8_t month);
+    /**
+     * Method to find the last time an alarm matched.
+     * @param now The current time
+     * @param alarm A daily (day = DAILY) or weekly alarm; the seconds are part of the match
+     * @return Returns the latest RTCepoch not after now at which the alarm matches
+     */
+    static RTCepoch previousOccurrence(RTCepoch now, const RTCalarm& alarm);
+    /**
+     * Method to find the next time an alarm matches.
+     *
+     * The time until the alarm rings is nextOccurrence(now, alarm) - now.
+     * @return Returns the earliest RTCepoch after now at which the alarm matches
+     */
+    static RTCepoch nextOccurrence(RTCepoch now, const RTCalarm& alarm);
+
+    /*--------------------------------------------------------------------------------------------------------------------
+     *                                   Software clock driven by the 1Hz square wave
+     ---------------------------------------------------------------------------------------------------------------------*/
+
+    /**
+     * Method to start the software clock.
+     *
+     * The device outputs a 1Hz square wave on the INT/SQW pin; its falling edge coincides with the seconds update.
+     * The pin has to be attached to an interrupt that calls tick(). While the software clock runs, the alarms cannot
+     * pull the INT/SQW pin low, so alarm matches are detected in RAM and reported by alarmPending().
+     * @param resyncMinutes Minutes between two reads of the time keeping registers (at least 1)
+     */
+    void beginSoftClock(uint16_t resyncMinutes);
+    /// Stops the software clock and gives the INT/SQW pin back to the alarms.
+    void endSoftClock();
+    /// Must be called from the interrupt routine on every falling edge of the 1Hz square wave.
+    void tick();
+    /**
+     * Method to read the software clock.
+     *
+     * Applies the seconds counted by tick() to the last read clock data. The registers are only read every
+     * resyncMinutes minutes or after requestResync(). A new minute still takes one temperature sample. A read of
+     * the registers also reads the alarm flags, so an alarm whose second was skipped (lost edges) is still pending.
+     * @return Returns an RTCdata object that holds the current time
+     */
+    RTCdata softTime();
+    /// The next softTime() call reads the time keeping registers.
+    void requestResync();
+    /// True if the software clock runs.
+    bool softClockRunning() const;
+    /**
+     * True if the driver has no work until the next interrupt: no EEPROM write is queued or running (the write queue
+     * is serviced by poll(), not by an interrupt) and every edge counted by tick() was applied by softTime().
+     * A sketch that powers the MCU down checks it first; the state of the driver is kept across the sleep.
+     */
+    bool sleepReady() const;
+    /// True if an enabled alarm matched the software clock. Cleared by snoozeAlarm().
+    bool alarmPending();
+    /// Last temperature sample taken by readTime(), readSnapshot() or softTime(), in 0.25 Celcius steps.
+    int16_t lastTemperature() const;
+    /**
+     * Method to read the statistics of the minute samples of the current hour (0.25 Celcius steps).
+     * @return The number of samples taken in the current hour; mean, min and max are not changed if it is 0
+     */
+    uint8_t currentHourTemperature(int16_t& mean, int16_t& min, int16_t& max) const;
 
     /*--------------------------------------------------------------------------------------------------------------------
      *                                   Methods to interact with the alarms
@@ -263,7 +843,8 @@ public:
 
     /**
      * Method to check whether the alarms were triggered.
-     * @return Returns 0 if both alarm flags are off, 1 if alarm 1 flag is on, 2 if alarm 2 flag is on
+     * @return Returns 0 if both alarm flags are on, 1 if alarm 1 flag is on, 2 if alarm 2 flag is on, 3 if none
+     * is on or the status register cannot be read
      */
     uint8_t checkAlarmFlag();
     /**
@@ -311,6 +892,16 @@ public:
      * @param alarmNumber alarmNumber Number of the alarm (1 or 2)
      */
     void setAlarmWeekly(uint8_t alarmNumber, uint8_t hour, const uint8_t minute, const dayOfWeek day);
+    /**
+     * Method to move an alarm to another time and day, writing only the alarm registers that change.
+     *
+     * Moving an alarm by a few minutes usually writes the minutes register alone. The enabled state is kept.
+     * While the alarm table holds alarms, alarm 1 belongs to it and is left alone.
+     * @param alarmNumber The number of the alarm (1 or 2); alarm 2 has no seconds, they are ignored
+     * @param alarm The new time and day (DAILY or a day of the week); enabled is ignored
+     * @return False if nothing was changed: a wrong alarm number, or alarm 1 while the alarm table holds it
+     */
+    bool updateAlarm(uint8_t alarmNumber, const RTCalarm& alarm);
     /**
      * Method to toggle the alarm ON or OFF.
      * @param alarmNumber The number of the alarm (1 or 2)
@@ -322,16 +913,99 @@ public:
     ///This method sets both alarm flags to 0.
     void snoozeAlarm();
 
+    /*--------------------------------------------------------------------------------------------------------------------
+     *                                   Alarm table: any number of alarms on alarm 1
+     ---------------------------------------------------------------------------------------------------------------------*/
+
+    /// The number of alarms in the alarm table; always 0 when ALARM_TABLE_ENTRIES is 0.
+    uint8_t tableAlarmCount() const;
+#if ALARM_TABLE_ENTRIES
+    /**
+     * Method to add a daily or weekly alarm to the alarm table.
+     *
+     * The table keeps its alarms in the EEPROM and, in RAM, ordered by the next time they ring (a heap): the earliest
+     * is programmed into the alarm 1 registers as a date match alarm, so the INT/SQW pin (or alarmPending() with
+     * the software clock) signals it without polling. While the table holds alarms, the alarm 1 registers belong to
+     * it and the alarm 1 of the user is kept in RAM: setAlarm(1, ...), setAlarmDaily(1, ...), setAlarmWeekly(1, ...),
+     * toggleAlarm(1, ...), readAlarm(1), alarmState(1) and storeAlarmEEPROM(1) work on that copy, which is
+     * programmed again, enabled or not, when the last alarm of the table is removed (updateAlarm(1, ...) is refused).
+     * @param alarm The time and day (DAILY or a day of the week) of the alarm; enabled is ignored
+     * @return The slot of the alarm, ALARM_TABLE_NONE if the table is full
+     */
+    uint8_t addTableAlarm(const RTCalarm& alarm);
+    /**
+     * Method to remove an alarm from the alarm table. The alarm 1 of the user is programmed again when the last alarm
+     * is removed.
+     * @param slot The slot returned by addTableAlarm()
+     * @return False if the slot holds no alarm
+     */
+    bool removeTableAlarm(uint8_t slot);
+    /**
+     * Method to read an alarm of the alarm table from the EEPROM.
+     * @param slot The slot returned by addTableAlarm()
+     * @return The alarm; enabled is false if the slot holds no alarm
+     */
+    RTCalarm readTableAlarm(uint8_t slot);
+    /**
+     * Method to find the alarm of the table that rings next (the one programmed into alarm 1). O(1)
+     * @param when Receives the time it rings; not changed if the table is empty
+     * @return Its slot, ALARM_TABLE_NONE if the table is empty
+     */
+    uint8_t nextTableAlarm(RTCdata& when) const;
+    /**
+     * Method to take the alarm of the table that rang and program the next one into alarm 1. O(log n)
+     *
+     * Call it when alarm 1 rang (checkAlarmFlag() returned 0 or 1, or alarmPending() was true), and again as long as
+     * it returns a slot: alarms of the table set to the same time ring together. It clears the alarm 1 flag, and
+     * the alarm that rang is scheduled for its next day or week.
+     * @return The slot of the alarm that rang, ALARM_TABLE_NONE if none is due (or its record cannot be read)
+     */
+    uint8_t advanceAlarmTable();
+#endif
+
     /*--------------------------------------------------------------------------------------------------------------------
      *                                   Methods to read the temperature
      ---------------------------------------------------------------------------------------------------------------------*/
 
+    /// Reads temperature registers and returns value in 0.25 Celcius steps (the resolution of the device).
+    /// Returns the last sample if the registers cannot be read.
+    int16_t readQuarterCelcius();
     /// Reads temperature registers and returns value in Celcius.
     float readCelcius();
     /// Uses readCelcius method, converts value to Fahrenheit.
     float readFahrenheit();
     /// Uses readCelcius method, converts value to Kelvin.
     float readKelvin();
+    /// Converts 0.25 Celcius steps (e.g. RTCsnapshot::temperature) to Celcius.
+    static float toCelcius(int16_t quarterDegrees);
+    /// Converts a Celcius value to Fahrenheit.
+    static float toFahrenheit(float celcius);
+    /// Converts a Celcius value to Kelvin.
+    static float toKelvin(float celcius);
+
+    /*--------------------------------------------------------------------------------------------------------------------
+     *                                   Fixed point temperature (no floating point code)
+     ---------------------------------------------------------------------------------------------------------------------*/
+
+    /// Reads temperature registers and returns value in 0.01 Celcius steps.
+    int16_t readCentiCelcius();
+    /// Reads temperature registers and returns value in 0.01 Fahrenheit steps.
+    int16_t readCentiFahrenheit();
+    /// Reads temperature registers and returns value in 0.01 Kelvin steps.
+    uint16_t readCentiKelvin();
+    /// Converts 0.25 Celcius steps to 0.01 Celcius steps (exact).
+    static int16_t quarterToCentiCelcius(int16_t quarterDegrees);
+    /// Converts 0.25 Celcius steps to 0.01 Fahrenheit steps (exact: 0.25 C is 0.45 F).
+    static int16_t quarterToCentiFahrenheit(int16_t quarterDegrees);
+    /// Converts 0.25 Celcius steps to 0.01 Kelvin steps (exact).
+    static uint16_t quarterToCentiKelvin(int16_t quarterDegrees);
+    /**
+     * Method to format a value in 0.01 steps with two decimals, like Print::print(float) does (e.g. "-4.25").
+     * @param centi The value in 0.01 steps
+     * @param buffer Receives the text and the terminating 0 (at least 8 bytes)
+     * @return Returns the number of characters written, without the terminating 0
+     */
+    static uint8_t formatCenti(int32_t centi, char buffer[]);
 
     /*--------------------------------------------------------------------------------------------------------------------
      *                                   Methods to output sqw
@@ -369,7 +1043,134 @@ public:
      * @param enable True -> enables the oscillator; False -> disables the oscillator
      */
     void enableOSC(bool enable);
+    /**
+     * Method to drop the RAM copies of the control and status registers.
+     *
+     * The next access reads them again from the device. Call it if the registers could have
+     * been changed behind the library's back (another bus master, power loss of the module).
+     */
+    void invalidateRegisterCache();
+
+    /*--------------------------------------------------------------------------------------------------------------------
+     *                                   Bus errors and retries
+     ---------------------------------------------------------------------------------------------------------------------*/
+
+    /**
+     * Method to set how a failed transaction (NACK, short read) is repeated.
+     *
+     * A transaction is tried at most retries + 1 times; the first retry waits backoffMicros, every further one
+     * twice as long as the one before. While an EEPROM write cycle may still run (EEPROM_WRITE_TIMEOUT_MS), a NACK
+     * of the acknowledge polling is its answer and is not retried; poll() retries it after that, and retries the
+     * chunks it writes, one attempt per call.
+     * @param retries Retries after the first attempt (BUS_RETRIES by default, 0 to disable)
+     * @param backoffMicros Wait before the first retry (BUS_BACKOFF_MICROS by default)
+     */
+    void setRetryPolicy(uint8_t retries, uint16_t backoffMicros);
+    /**
+     * Method to read the failure counters of a device.
+     * @param address DS3231_ADDRESS or EEPROM_ADDRESS
+     */
+    const BusCounters& busCounters(uint8_t address) const;
+    /// Clears the failure counters of both devices.
+    void resetBusCounters();
+    /// Result of the last transaction with the DS3231 or the EEPROM (after its retries).
+    BusStatus busStatus() const;
+
+#if DS3231_STATS
+    /*--------------------------------------------------------------------------------------------------------------------
+     *                                   Bus instrumentation (DS3231_STATS)
+     ---------------------------------------------------------------------------------------------------------------------*/
+
+    /// Totals of one entry of the stats table.
+    const MethodStats& methodStats(DS3231Method method) const;
+    /// Clears the stats table.
+    void resetStats();
+    /**
+     * Method to print the stats table, one line per entry that was called.
+     *
+     * Columns: calls, transactions, bytes written, bytes read, micros in total and per call.
+     * @param out Where the table is printed, e.g. Serial
+     */
+    void dumpStats(Print& out);
+#endif
+
+    /*--------------------------------------------------------------------------------------------------------------------
+     *                                   Non-blocking EEPROM writes
+     ---------------------------------------------------------------------------------------------------------------------*/
+
+    /**
+     * Method to queue a write to the EEPROM without waiting for it.
+     *
+     * The data is copied, split on 32 byte page boundaries and written by poll(), one page per write cycle.
+     * @param address The EEPROM address of the first byte
+     * @param byteBuffer The data to be written
+     * @param bytes The number of bytes (at most EEPROM_QUEUE_SIZE)
+     * @return False if the queue has no room for the data; nothing is queued in that case
+     */
+    bool writeEEPROMAsync(uint16_t address, const uint8_t byteBuffer[], uint16_t bytes);
+    /**
+     * Method to service the EEPROM write queue. Never waits.
+     *
+     * While a write cycle runs, the EEPROM is polled for an acknowledge; once it answers, the next page is sent.
+     * readTime(), readSnapshot() and softTime() call it too, but a sketch should call it from loop().
+     *
+     * An EEPROM that is missing, stuck or write protected cannot block the queue. The acknowledge polls of a write
+     * cycle that does not end within EEPROM_WRITE_TIMEOUT_MS and the chunks that are not acknowledged follow the
+     * retry policy (setRetryPolicy()), one attempt per call after the backoff; when the retries are used up the
+     * write cycle is given up, or the write is dropped (busStatus() and busCounters() tell why).
+     * @return BUS_OK, or the error of a write cycle or a write that failed in this call
+     */
+    BusStatus poll();
+    /// True if nothing is queued and no write cycle is running.
+    bool eepromIdle() const;
+    /**
+     * Services the queue until every queued write has been completed or dropped.
+     * @return BUS_OK, or the error of the first write that failed
+     */
+    BusStatus flushEEPROM();
+    /// Sets a function called each time the queue has been written completely (nullptr to remove it).
+    void onEEPROMWritten(void (*callback)());
+
+    /*--------------------------------------------------------------------------------------------------------------------
+     *                                   Temperature history (minute, hour, day and week tiers)
+     ---------------------------------------------------------------------------------------------------------------------*/
+
+    /**
+     * Method to read the newest closed periods of one tier of the temperature history.
+     *
+     * Every 60 minute samples close an hour, every 24 hours close a day and every 7 days close a week. The
+     * periods are served from RAM; the hour, day and week tiers are restored from the EEPROM by begin().
+     * Minutes have the same mean, min and max.
+     * @param tier The resolution of the periods
+     * @param temperatures Receives up to count periods, the newest first
+     * @param count The number of periods wanted (at most 60 minutes, 24 hours, 7 days or 4 weeks)
+     * @return The number of periods written, fewer than count if the history is shorter
+     */
+    uint8_t readTemperatureHistory(TempTier tier, TempAggregate* temperatures, uint8_t count);
+    /**
+     * Method to read the statistics of the period being collected by a tier.
+     * @param tier TIER_HOUR, TIER_DAY or TIER_WEEK
+     * @param temperature Receives mean, min and max of the closed minutes, hours or days of the period
+     * @return The number of minutes, hours or days collected; temperature is not changed if it is 0
+     */
+    uint8_t currentTemperature(TempTier tier, TempAggregate& temperature);
+    /**
+     * Method to read the hourly temperature means of the last 24h.
+     * @param temperatures Receives 24 values in 0.25 Celcius steps, the newest first
+     */
+    void readLast24hTemperature(int16_t* temperatures);
+    /**
+     * Method to read the hourly temperature means of the last 24h.
+     * @param temperatures Receives 24 values in Celcius, the newest first
+     */
     void readLast24hTemperature(float* temperatures);
+    /**
+     * Method to replace the hourly temperature history (used for testing the graph).
+     *
+     * Only the hours in RAM are replaced: the values are not logged to the EEPROM and are not added to the day being
+     * collected, so begin() after a reset shows the measured hours again.
+     * @param temperatures 24 values, the newest first
+     */
     void writeDummyTemperatures(float* temperatures);
 };
 
@@ -0,0 +1,205 @@
+//
+// Bus transports for the DS3231 driver.
+//
+// The driver reaches the DS3231 and the EEPROM only through the class named by DS3231_BUS. A transport is a
+// class with static members only, so every call is resolved at compile time and inlined; there is no object,
+// no pointer and no virtual call between the driver and the bus:
+//
+//   static const uint8_t MAX_TRANSFER;     // largest write (address bytes included) or read of one transaction
+//   static void begin();                   // sets the bus up, called by DS3231::begin()
+//   static void beginWrite(uint8_t address);
+//   static void write(uint8_t data);
+//   static uint8_t endWrite(bool stop);    // 0 -> acknowledged; 2 -> NACK on address; 3 -> NACK on data
+//   static uint8_t read(uint8_t address, uint8_t buffer[], uint8_t length); // bytes read, 0 -> NACK
+//
+// endWrite(false) leaves the bus to the read that follows (repeated START). The transport is picked at build
+// time, for the library and the sketch alike (e.g. -DDS3231_BUS=TWIBus). A transport defined outside this file
+// is included through DS3231_BUS_HEADER (e.g. -DDS3231_BUS=SimBus -DDS3231_BUS_HEADER='"SimBus.h"').
+//
+
+#ifndef DS3231_BUS_H
+#define DS3231_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#ifndef DS3231_BUS
+#define DS3231_BUS WireBus
+#endif
+
+#ifdef DS3231_BUS_HEADER
+#include DS3231_BUS_HEADER
+#endif
+
+/// @brief Transport over the Arduino Wire library (the default).
+struct WireBus{
+    /// the Wire transmit and receive buffers hold 32 bytes
+    static const uint8_t MAX_TRANSFER = 32;
+
+    static void begin() {
+        Wire.begin();
+    }
+    static void beginWrite(uint8_t address) {
+        Wire.beginTransmission(address);
+    }
+    static void write(uint8_t data) {
+        Wire.write(data);
+    }
+    static uint8_t endWrite(bool stop) {
+        return Wire.endTransmission(stop);
+    }
+    static uint8_t read(uint8_t address, uint8_t buffer[], uint8_t length) {
+        uint8_t received = Wire.requestFrom(address, length, (uint8_t)true);
+        if(received != length)
+            return 0;
+        for(uint8_t i = 0; i < length; i++)
+            buffer[i] = Wire.read();
+        return length;
+    }
+};
+
+/// @brief Bus traffic seen by CountingBus since start.
+struct BusTally{
+    /// START ... STOP sequences; a repeated START does not open a new transaction
+    uint32_t transactions;
+    /// bytes sent after the address, register and memory addresses included
+    uint32_t bytesWritten;
+    uint32_t bytesRead;
+};
+
+/**
+ * @brief Transport adapter that counts the traffic of another transport.
+ *
+ * Used by the driver instead of DS3231_BUS when DS3231_STATS is set; the counting is a few increments per byte.
+ */
+template<typename Transport>
+struct CountingBus{
+    static const uint8_t MAX_TRANSFER = Transport::MAX_TRANSFER;
+
+    static BusTally& tally() {
+        static BusTally counters = {0, 0, 0};
+        return counters;
+    }
+    static void begin() {
+        Transport::begin();
+    }
+    static void beginWrite(uint8_t address) {
+        if(!open())
+            tally().transactions++;
+        Transport::beginWrite(address);
+    }
+    static void write(uint8_t data) {
+        tally().bytesWritten++;
+        Transport::write(data);
+    }
+    static uint8_t endWrite(bool stop) {
+        uint8_t status = Transport::endWrite(stop);
+        open() = !stop && status == 0; // a repeated START follows
+        return status;
+    }
+    static uint8_t read(uint8_t address, uint8_t buffer[], uint8_t length) {
+        if(!open())
+            tally().transactions++;
+        open() = false;
+        uint8_t received = Transport::read(address, buffer, length);
+        tally().bytesRead += received;
+        return received;
+    }
+
+private:
+    static bool& open() {
+        static bool repeatedStart = false;
+        return repeatedStart;
+    }
+};
+
+#if defined(__AVR__) && defined(TWCR)
+#include <util/twi.h>
+
+/// SCL frequency of TWIBus
+#ifndef DS3231_BUS_CLOCK
+#define DS3231_BUS_CLOCK 100000UL
+#endif
+
+/**
+ * @brief Transport driving the AVR TWI registers directly.
+ *
+ * Bytes go out while they are written, so there is no buffer, no copy and no 32 byte limit, and no TWI interrupt
+ * handler is linked in. A stuck bus ends a transaction as an error instead of hanging.
+ */
+struct TWIBus{
+    static const uint8_t MAX_TRANSFER = 255;
+
+    static void begin() {
+        TWSR = 0; // prescaler 1
+        TWBR = ((F_CPU / DS3231_BUS_CLOCK) - 16) / 2;
+        TWCR = _BV(TWEN);
+    }
+    static void beginWrite(uint8_t address) {
+        error() = TWIBus::start(address << 1 | TW_WRITE) ? 0 : 2;
+    }
+    static void write(uint8_t data) {
+        if(error())
+            return;
+        TWDR = data;
+        TWCR = _BV(TWINT) | _BV(TWEN);
+        if(TWIBus::wait() != TW_MT_DATA_ACK)
+            error() = 3;
+    }
+    static uint8_t endWrite(bool stop) {
+        if(stop || error())
+            TWIBus::stop();
+        return error();
+    }
+    static uint8_t read(uint8_t address, uint8_t buffer[], uint8_t length) {
+        if(!TWIBus::start(address << 1 | TW_READ)){
+            TWIBus::stop();
+            return 0;
+        }
+        for(uint8_t i = 0; i < length; i++){
+            // ACK every byte but the last one
+            TWCR = _BV(TWINT) | _BV(TWEN) | (i + 1 < length ? _BV(TWEA) : 0);
+            if(TWIBus::wait() == 0){
+                TWIBus::stop();
+                return 0;
+            }
+            buffer[i] = TWDR;
+        }
+        TWIBus::stop();
+        return length;
+    }
+
+private:
+    /// status of the current write transaction, in endWrite() codes
+    static uint8_t& error() {
+        static uint8_t status = 0;
+        return status;
+    }
+    /// waits for the TWI to finish the current step; 0 if it never does
+    static uint8_t wait() {
+        uint16_t guard = 0xFFFF;
+        while(!(TWCR & _BV(TWINT)))
+            if(--guard == 0)
+                return 0;
+        return TW_STATUS;
+    }
+    /// (repeated) START and address; true if the address was acknowledged
+    static bool start(uint8_t sla) {
+        TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN);
+        uint8_t status = TWIBus::wait();
+        if(status != TW_START && status != TW_REP_START)
+            return false;
+        TWDR = sla;
+        TWCR = _BV(TWINT) | _BV(TWEN);
+        status = TWIBus::wait();
+        return status == TW_MT_SLA_ACK || status == TW_MR_SLA_ACK;
+    }
+    static void stop() {
+        TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN);
+        uint16_t guard = 0xFFFF;
+        while((TWCR & _BV(TWSTO)) && --guard);
+    }
+};
+#endif
+
+#endif //DS3231_BUS_H
@@ -0,0 +1,96 @@
+//
+// Snooze of the alarms of the DS3231: re-arming an ignored alarm and restoring the one the user set.
+//
+
+#include "SnoozeManager.h"
+
+SnoozeManager::SnoozeManager(DS3231& rtc) : rtc(rtc) {
+    states[0].count = 0;
+    states[1].count = 0;
+}
+
+/**
+ * @details A snooze of alarm 1 that was under way when the table took the alarm is forgotten: the table
+ * reprogrammed the registers, there is nothing left to restore.
+ */
+SnoozeManager::SnoozeState* SnoozeManager::state(uint8_t alarmNumber) {
+    if(alarmNumber != 1 && alarmNumber != 2)
+        return nullptr;
+    if(alarmNumber == 1 && rtc.tableAlarmCount() != 0){
+        states[0].count = 0;
+        return nullptr;
+    }
+    return &states[alarmNumber - 1];
+}
+
+/**
+ * @details The minutes are counted from midnight, so one comparison finds the carry into the next day; a daily alarm
+ * has no day to carry into.
+ */
+RTCalarm SnoozeManager::later(const RTCalarm& alarm, uint8_t minutes) {
+    RTCalarm moved = alarm;
+    uint16_t minute = (uint16_t)(alarm.hour % 24) * 60 + alarm.minutes % 60 + minutes;
+    while(minute >= 24 * 60){
+        minute -= 24 * 60;
+        if(moved.day != DAILY)
+            moved.day = (dayOfWeek)(moved.day % 7 + 1);
+    }
+    moved.hour = minute / 60;
+    moved.minutes = minute % 60;
+    moved.pm = moved.hour >= 12;
+    return moved;
+}
+
+void SnoozeManager::restore(uint8_t alarmNumber, SnoozeState& snooze) {
+    snooze.count = 0;
+    rtc.updateAlarm(alarmNumber, snooze.original);
+}
+
+/**
+ * @details The alarm that rang is the one in the registers, so the snooze is that alarm SNOOZE_MINUTES later: a
+ * snoozed alarm that is ignored again moves on from the snooze time, not from the time the user set.
+ */
+bool SnoozeManager::ignored(uint8_t alarmNumber) {
+    SnoozeState* snooze = state(alarmNumber);
+    if(!snooze)
+        return false;
+    RTCalarm rang = rtc.readAlarm(alarmNumber);
+    if(snooze->count == 0)
+        snooze->original = rang;
+    if(++snooze->count == SNOOZE_MAX_IGNORED){
+        restore(alarmNumber, *snooze);
+        return false;
+    }
+    rtc.updateAlarm(alarmNumber, SnoozeManager::later(rang, SNOOZE_MINUTES));
+    return true;
+}
+
+void SnoozeManager::stopped(uint8_t alarmNumber) {
+    SnoozeState* snooze = state(alarmNumber);
+    if(snooze && snooze->count)
+        restore(alarmNumber, *snooze);
+}
+
+void SnoozeManager::reset(uint8_t alarmNumber) {
+    SnoozeState* snooze = state(alarmNumber);
+    if(snooze)
+        snooze->count = 0;
+}
+
+bool SnoozeManager::isSnoozed(uint8_t alarmNumber) const {
+    return ignoredCount(alarmNumber) != 0;
+}
+
+uint8_t SnoozeManager::ignoredCount(uint8_t alarmNumber) const {
+    if(alarmNumber != 1 && alarmNumber != 2)
+        return 0;
+    if(alarmNumber == 1 && rtc.tableAlarmCount() != 0)
+        return 0; // the table holds alarm 1, a snooze from before it is void
+    return states[alarmNumber - 1].count;
+}
+
+RTCalarm SnoozeManager::userAlarm(uint8_t alarmNumber) const {
+    if(isSnoozed(alarmNumber))
+        return states[alarmNumber - 1].original;
+    return rtc.readAlarm(alarmNumber);
+}
@@ -0,0 +1,78 @@
+//
+// Snooze of the alarms of the DS3231: re-arming an ignored alarm and restoring the one the user set.
+//
+
+#ifndef DS3231_RTC_SNOOZEMANAGER_H
+#define DS3231_RTC_SNOOZEMANAGER_H
+
+#include <Arduino.h>
+#include "DS3231.h"
+
+/// an ignored alarm rings again this many minutes after it rang
+#ifndef SNOOZE_MINUTES
+#define SNOOZE_MINUTES 5
+#endif
+/// after this many ignored rings in a row the alarm the user set is restored
+#ifndef SNOOZE_MAX_IGNORED
+#define SNOOZE_MAX_IGNORED 5
+#endif
+
+/**
+ * @brief Owns the snooze state of the two alarms of the chip.
+ *
+ * When an alarm rings and nobody stops it, ignored() moves it SNOOZE_MINUTES later; when the user stops it, or after
+ * SNOOZE_MAX_IGNORED ignored rings in a row, the alarm the user set is programmed again. That alarm is kept in RAM
+ * from the first ignored ring and the snooze time is computed from the alarm registers alone (the driver's RAM copy),
+ * so a snooze reads neither the clock nor the EEPROM and writes only the alarm registers that change, usually the
+ * minutes register alone (DS3231::updateAlarm()).
+ *
+ * The alarm the user set stays in the EEPROM (storeAlarmEEPROM()) for begin() after a reset; a snoozed alarm is
+ * never stored there. While the alarm table holds alarms, alarm 1 belongs to the table: ignored(1) and stopped(1)
+ * leave it alone, and the table schedules its next alarm itself (DS3231::advanceAlarmTable()).
+ */
+class SnoozeManager{
+private:
+    struct SnoozeState{
+        /// the alarm as the user set it, valid while count is not 0
+        RTCalarm original;
+        /// ignored rings in a row
+        uint8_t count;
+    };
+
+    DS3231& rtc;
+    SnoozeState states[2];
+
+    /// The state of alarm 1 or 2, nullptr for any other number and for alarm 1 while the alarm table holds it.
+    SnoozeState* state(uint8_t alarmNumber);
+    void restore(uint8_t alarmNumber, SnoozeState& snooze);
+
+public:
+    explicit SnoozeManager(DS3231& rtc);
+    /**
+     * The alarm rang and nobody stopped it: it rings again SNOOZE_MINUTES after the time it rang, or is restored to
+     * the alarm the user set after SNOOZE_MAX_IGNORED ignored rings in a row.
+     * @param alarmNumber The number of the alarm that rang (1 or 2)
+     * @return True if the alarm was snoozed, false if it was restored
+     */
+    bool ignored(uint8_t alarmNumber);
+    /// The user stopped the alarm: the alarm the user set is restored if it was snoozed.
+    void stopped(uint8_t alarmNumber);
+    /// The user set the alarm: the snooze is forgotten and the alarm in the registers is the one to keep.
+    void reset(uint8_t alarmNumber);
+    /// True if the alarm in the registers is a snooze of the alarm the user set.
+    bool isSnoozed(uint8_t alarmNumber) const;
+    /// Ignored rings in a row of the alarm.
+    uint8_t ignoredCount(uint8_t alarmNumber) const;
+    /// The alarm as the user set it: the one kept in RAM while snoozed, the one in the registers otherwise.
+    RTCalarm userAlarm(uint8_t alarmNumber) const;
+    /**
+     * Adds minutes to the time of an alarm, carrying into the hour and, for a weekly alarm, into the day of the
+     * week (after Sunday comes Monday).
+     * @param alarm A daily or weekly alarm
+     * @param minutes Minutes to add
+     * @return The alarm moved later; the seconds and enabled are kept
+     */
+    static RTCalarm later(const RTCalarm& alarm, uint8_t minutes);
+};
+
+#endif //DS3231_RTC_SNOOZEMANAGER_H
@@ -0,0 +1,69 @@
+//
+// Shadow framebuffer for a 16x2 HD44780 display.
+//
+
+#include "LcdFrame.h"
+
+LcdFrame::LcdFrame(LiquidCrystal& lcd) : lcd(lcd) {
+    shownValid = false;
+    charsSent = 0;
+    cursorMoves = 0;
+    clear();
+}
+
+void LcdFrame::clear() {
+    memset(cells, ' ', sizeof(cells));
+    col = 0;
+    row = 0;
+}
+
+void LcdFrame::setCursor(uint8_t col, uint8_t row) {
+    this->col = col;
+    this->row = row;
+}
+
+size_t LcdFrame::write(uint8_t character) {
+    if(row >= LCD_FRAME_ROWS || col >= LCD_FRAME_COLS)
+        return 0; // off the display
+    cells[row][col++] = character;
+    return 1;
+}
+
+/**
+ * @details The position of the display cursor is not known when flush() starts: the sketch moves it for the blinking
+ * cursor, and createChar() leaves the address counter in the character generator memory. So the first changed cell
+ * always gets a cursor move, the following cells only if an unchanged cell lies between them.
+ */
+uint8_t LcdFrame::flush() {
+    uint8_t sent = 0;
+    for(uint8_t r = 0; r < LCD_FRAME_ROWS; r++){
+        uint8_t cursor = 0xFF; // display cursor column on this row, 0xFF -> elsewhere
+        for(uint8_t c = 0; c < LCD_FRAME_COLS; c++){
+            if(shownValid && shown[r][c] == cells[r][c])
+                continue;
+            if(cursor != c){
+                lcd.setCursor(c, r);
+                cursorMoves++;
+            }
+            lcd.write(cells[r][c]);
+            shown[r][c] = cells[r][c];
+            cursor = c + 1;
+            sent++;
+        }
+    }
+    shownValid = true;
+    charsSent += sent;
+    return sent;
+}
+
+void LcdFrame::invalidate() {
+    shownValid = false;
+}
+
+uint32_t LcdFrame::sentCharacters() const {
+    return charsSent;
+}
+
+uint32_t LcdFrame::sentCursorMoves() const {
+    return cursorMoves;
+}
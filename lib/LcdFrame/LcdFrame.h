@@ -0,0 +1,63 @@
+//
+// Shadow framebuffer for a 16x2 HD44780 display.
+//
+
+#ifndef DS3231_RTC_LCDFRAME_H
+#define DS3231_RTC_LCDFRAME_H
+
+#include <Arduino.h>
+#include <LiquidCrystal.h>
+
+#define LCD_FRAME_COLS 16
+#define LCD_FRAME_ROWS 2
+
+/**
+ * @brief Draws into RAM and sends only the characters that changed to the display.
+ *
+ * print(), write(), setCursor() and clear() only change the frame; flush() compares it with what the display shows
+ * and sends the differing cells, moving the cursor only where a run of changed cells starts. Every character costs
+ * two 4 bit transfers on the display bus and a cursor move costs as much as a character, so redrawing a whole screen
+ * where one digit changed sends 1 character and 1 cursor move instead of 32 characters and 2 cursor moves.
+ *
+ * Characters written past the end of a row are dropped, like on the display. Whatever is sent to the display
+ * without the frame (lcd.clear(), lcd.print()) must be followed by invalidate().
+ */
+class LcdFrame : public Print{
+private:
+    LiquidCrystal& lcd;
+    /// what is drawn
+    uint8_t cells[LCD_FRAME_ROWS][LCD_FRAME_COLS];
+    /// what the display shows, if shownValid
+    uint8_t shown[LCD_FRAME_ROWS][LCD_FRAME_COLS];
+    bool shownValid;
+    uint8_t col;
+    uint8_t row;
+    /// characters and cursor moves sent by flush() since start
+    uint32_t charsSent;
+    uint32_t cursorMoves;
+
+public:
+    explicit LcdFrame(LiquidCrystal& lcd);
+    /// Fills the frame with spaces and moves the cursor of the frame to 0, 0; nothing is sent.
+    void clear();
+    /// Moves the cursor of the frame; nothing is sent.
+    void setCursor(uint8_t col, uint8_t row);
+    /// Draws one character at the cursor of the frame (custom characters are 0 - 7).
+    size_t write(uint8_t character) override;
+    using Print::write;
+    /**
+     * Sends the cells that differ from the display. The cursor of the display is left after the last character sent:
+     * set it again to show a blinking cursor.
+     * @return The number of characters sent
+     */
+    uint8_t flush();
+    /// The display content is unknown: the next flush() sends every cell.
+    void invalidate();
+
+    /// Characters sent by flush() since start.
+    uint32_t sentCharacters() const;
+    /// Cursor moves sent by flush() since start.
+    uint32_t sentCursorMoves() const;
+};
+
+#endif //DS3231_RTC_LCDFRAME_H
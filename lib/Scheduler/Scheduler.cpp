@@ -0,0 +1,181 @@
+//
+// Cooperative task scheduler for the clock sketch.
+//
+
+#include "Scheduler.h"
+#ifdef __AVR__
+#include <avr/sleep.h>
+#endif
+
+Scheduler::Scheduler() {
+    taskCount = 0;
+    pendingEvents = 0;
+    passes = 0;
+    runs = 0;
+    busyMicros = 0;
+    sleeps = 0;
+    deepSleeps = 0;
+}
+
+// true once now has reached due; correct across the millis() wrap as long as due is less than 24 days away
+bool Scheduler::expired(uint32_t now, uint32_t due) {
+    return (int32_t)(now - due) >= 0;
+}
+
+uint8_t Scheduler::addTask(TaskFunction run, uint16_t interval, uint8_t events) {
+    if(taskCount == SCHEDULER_MAX_TASKS)
+        return SCHEDULER_NO_TASK;
+    SchedulerTask& task = tasks[taskCount];
+    task.run = run;
+    task.events = events;
+    task.interval = interval;
+    task.due = millis() + interval;
+    task.armed = interval != 0;
+    task.enabled = true;
+    return taskCount++;
+}
+
+void Scheduler::enable(uint8_t task, bool enable) {
+    if(task >= taskCount)
+        return;
+    if(enable == tasks[task].enabled)
+        return;
+    tasks[task].enabled = enable;
+    if(enable && tasks[task].interval){
+        tasks[task].due = millis() + tasks[task].interval;
+        tasks[task].armed = true;
+    }
+}
+
+void Scheduler::setInterval(uint8_t task, uint16_t interval) {
+    if(task >= taskCount)
+        return;
+    tasks[task].interval = interval;
+    tasks[task].due = millis() + interval;
+    tasks[task].armed = interval != 0;
+}
+
+void Scheduler::runIn(uint8_t task, uint16_t ms) {
+    if(task >= taskCount)
+        return;
+    tasks[task].due = millis() + ms;
+    tasks[task].armed = true;
+}
+
+void Scheduler::signal(uint8_t events) {
+    // an interrupt that signals between the read and the write would be lost; the interrupt flag is restored, not
+    // set, so this also works inside an interrupt handler (the host stand-in has no status register)
+#ifdef SREG
+    uint8_t sreg = SREG;
+    noInterrupts();
+    pendingEvents |= events;
+    SREG = sreg;
+#else
+    pendingEvents |= events;
+#endif
+}
+
+/**
+ * @details The pending events are taken at the start of the pass; events signalled while the tasks run wait for the
+ * next pass, so a task that signals its own event runs again on the next pass, not in a loop. A periodic task that
+ * fell behind skips the periods it missed instead of running once per missed period.
+ */
+uint8_t Scheduler::runPending() {
+    noInterrupts();
+    uint8_t events = pendingEvents;
+    pendingEvents = 0;
+    interrupts();
+    passes++;
+    uint8_t ran = 0;
+    for(uint8_t i = 0; i < taskCount; i++){
+        SchedulerTask& task = tasks[i];
+        if(!task.enabled)
+            continue;
+        uint32_t now = millis();
+        bool timer = task.armed && Scheduler::expired(now, task.due);
+        if(!timer && !(task.events & events))
+            continue;
+        if(timer){
+            if(task.interval){
+                task.due += task.interval;
+                if(Scheduler::expired(now, task.due))
+                    task.due = now + task.interval;
+            }
+            else task.armed = false;
+        }
+        uint32_t start = micros();
+        task.run();
+        busyMicros += micros() - start;
+        ran++;
+    }
+    runs += ran;
+    return ran;
+}
+
+uint32_t Scheduler::idleMillis() {
+    uint32_t now = millis();
+    uint32_t idle = SCHEDULER_NO_TIMER;
+    for(uint8_t i = 0; i < taskCount; i++){
+        if(!tasks[i].enabled || !tasks[i].armed)
+            continue;
+        if(Scheduler::expired(now, tasks[i].due))
+            return 0;
+        if(tasks[i].due - now < idle)
+            idle = tasks[i].due - now;
+    }
+    return idle;
+}
+
+bool Scheduler::eventsPending() const {
+    return pendingEvents != 0;
+}
+
+/**
+ * @details The events are checked with interrupts disabled and the AVR runs the instruction after sei before any
+ * interrupt, so an interrupt that fires after the check is taken after sleep_cpu(): it ends the sleep instead of
+ * waiting for the next one. The brown-out detector is turned off while powered down where the MCU allows it.
+ */
+bool Scheduler::sleep(bool powerDown) {
+    noInterrupts();
+    if(pendingEvents){
+        interrupts();
+        return false;
+    }
+#ifdef __AVR__
+    set_sleep_mode(powerDown ? SLEEP_MODE_PWR_DOWN : SLEEP_MODE_IDLE);
+    sleep_enable();
+#ifdef sleep_bod_disable
+    if(powerDown)
+        sleep_bod_disable();
+#endif
+    interrupts();
+    sleep_cpu();
+    sleep_disable();
+#else
+    interrupts();
+#endif
+    sleeps++;
+    if(powerDown)
+        deepSleeps++;
+    return true;
+}
+
+uint32_t Scheduler::passCount() const {
+    return passes;
+}
+
+uint32_t Scheduler::runCount() const {
+    return runs;
+}
+
+uint32_t Scheduler::busyTime() const {
+    return busyMicros;
+}
+
+uint32_t Scheduler::sleepCount() const {
+    return sleeps;
+}
+
+uint32_t Scheduler::deepSleepCount() const {
+    return deepSleeps;
+}
@@ -0,0 +1,107 @@
+//
+// Cooperative task scheduler for the clock sketch.
+//
+
+#ifndef DS3231_RTC_SCHEDULER_H
+#define DS3231_RTC_SCHEDULER_H
+
+#include <Arduino.h>
+
+/// tasks a Scheduler can hold
+#define SCHEDULER_MAX_TASKS 8
+/// returned by addTask() when the table is full
+#define SCHEDULER_NO_TASK 0xFF
+/// returned by idleMillis() when no timer runs
+#define SCHEDULER_NO_TIMER 0xFFFFFFFFUL
+
+typedef void (*TaskFunction)();
+
+/// @brief One entry of the task table.
+struct SchedulerTask{
+    TaskFunction run;
+    /// events (bit mask) that make the task run
+    uint8_t events;
+    /// the task runs every interval milliseconds; 0 -> only on its events and after runIn()
+    uint16_t interval;
+    /// millis() at which the timer of the task expires
+    uint32_t due;
+    /// the timer is running
+    bool armed;
+    bool enabled;
+};
+
+/**
+ * @brief Runs tasks when their trigger fires: a timer, an event signalled by an interrupt or by another task.
+ *
+ * Tasks run to completion one after the other, in the order they were added; none of them may block. An event is a
+ * bit of an 8 bit mask: signal() may be called from an interrupt, the event stays pending until the next pass of
+ * runPending(), where every task listening to it runs once however often it was signalled.
+ */
+class Scheduler{
+private:
+    SchedulerTask tasks[SCHEDULER_MAX_TASKS];
+    uint8_t taskCount;
+    volatile uint8_t pendingEvents;
+    /// passes of runPending() and task runs since start, for the duty cycle
+    uint32_t passes;
+    uint32_t runs;
+    uint32_t busyMicros;
+    /// sleep() calls that slept, all modes and powered down only
+    uint32_t sleeps;
+    uint32_t deepSleeps;
+
+    static bool expired(uint32_t now, uint32_t due);
+
+public:
+    Scheduler();
+    /**
+     * Adds a task.
+     * @param run Function called when the task is triggered
+     * @param interval Period in milliseconds; 0 -> the task has no periodic timer
+     * @param events Events (bit mask) that trigger the task; 0 -> none
+     * @return The id of the task, SCHEDULER_NO_TASK if the table is full
+     */
+    uint8_t addTask(TaskFunction run, uint16_t interval, uint8_t events);
+    /// Enables or disables a task; a disabled periodic task that is enabled restarts its timer.
+    void enable(uint8_t task, bool enable);
+    /// Changes the period of a task (0 stops its timer) and restarts the timer.
+    void setInterval(uint8_t task, uint16_t interval);
+    /// Runs the task once, ms milliseconds from now; replaces the next expiry of a periodic task.
+    void runIn(uint8_t task, uint16_t ms);
+    /// Marks events as pending. Safe to call from an interrupt.
+    void signal(uint8_t events);
+    /**
+     * Runs every task whose timer expired or whose events are pending, once.
+     * @return The number of tasks that ran
+     */
+    uint8_t runPending();
+    /// Milliseconds until the earliest timer expires, SCHEDULER_NO_TIMER if none runs; pending events are not counted.
+    uint32_t idleMillis();
+    /// True if events wait for runPending().
+    bool eventsPending() const;
+    /**
+     * Sleeps until the next interrupt, unless an event is pending. An event signalled between the check and the
+     * sleep instruction wakes the MCU at once, so none is left waiting for the next interrupt.
+     *
+     * In idle mode timer 0 keeps millis() running and wakes the MCU every millisecond. Powered down, only the pin
+     * change, level and TWI address interrupts wake it and millis() stops: only power down when no timer runs
+     * (idleMillis() returns SCHEDULER_NO_TIMER) and every task is triggered by events of such interrupts.
+     * On the host nothing sleeps; the call is counted as if it had.
+     * @param powerDown True for the power down mode, false for the idle mode
+     * @return False if an event was pending
+     */
+    bool sleep(bool powerDown);
+
+    /// Passes of runPending() since start.
+    uint32_t passCount() const;
+    /// Task runs since start.
+    uint32_t runCount() const;
+    /// Time spent in tasks since start, in microseconds (wraps after 71 minutes).
+    uint32_t busyTime() const;
+    /// sleep() calls that slept since start.
+    uint32_t sleepCount() const;
+    /// sleep() calls that powered down since start.
+    uint32_t deepSleepCount() const;
+};
+
+#endif //DS3231_RTC_SCHEDULER_H
@@ -3,7 +3,11 @@
 //
 
 #include <DS3231.h>
+#include <Scheduler.h>
 #include <LiquidCrystal.h>
+#include <LcdFrame.h>
+#include <Buttons.h>
+#include <SnoozeManager.h>
 //#include <Arduino.h>
 
 //Pins used for lcd display
@@ -19,33 +23,95 @@
 
 #define BUZZ_pin 6
 
+//Minutes between two I2C reads of the clock while it is driven by the 1Hz square wave.
+//0 -> the time registers are read on every display refresh and INT/SQW signals the alarms.
+
+#define SOFT_CLOCK_RESYNC 10
+
+//Sleep between two interrupts: 0 -> never; 1 -> idle mode while a task waits for a timer, power down otherwise
+//(only with SOFT_CLOCK_RESYNC: the clock task then runs on the square wave instead of a timer).
+
+#define LOW_POWER 1
+
 //Pins used for DS3231 RTC clock
 
-uint8_t INT_pin = 2; // LOW when alarm condition is met
+uint8_t INT_pin = 2; // LOW when alarm condition is met (1Hz square wave with SOFT_CLOCK_RESYNC)
 uint8_t SNOOZE_pin =5;
 uint8_t UP_pin = 4; // increment / toggle alarm1 / set alarm1 (while not in edit mode)
 uint8_t DOWN_pin = 3; // decrement / toggle alarm2 / set alarm2 (while not in edit mode)
 uint8_t GRAPH_pin = A0;
+bool intLevel = true; // last level of INT_pin seen by the pin change interrupt
+
+//Scheduler events
+
+#define EVENT_SECOND 0x01 // falling edge of the 1Hz square wave
+#define EVENT_ALARM 0x02 // alarm on INT/SQW, or an alarm match of the software clock
+#define EVENT_TIME_SET 0x04 // the time registers were changed
+#define EVENT_REDRAW 0x08 // the screen of the current mode is out of date
+#define EVENT_BUTTON 0x10 // a button pin changed
+
+//Milliseconds between two reads of the clock without the square wave (SOFT_CLOCK_RESYNC 0)
 
-// variables for alarm management
+#define CLOCK_POLL_MS 250
 
-bool AlarmState = false;
-bool alarmIgnored[2] = {false, false};
-uint8_t alarmIgnoredCount[2] = {0,0};
+//Milliseconds an "EXIT ... MENU" message stays on the screen
 
-//vectors that hold the number of days in each month;
-const uint8_t normalYear[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
-const uint8_t leapYear[12] = {31,29,31,30,31,30,31,31,30,31,30,31};
+#define MESSAGE_MS 500
+
+//Alarm ringing: the buzzer sounds and the screen blinks every ALARM_BLINK_MS, for ALARM_RING_MS at most
+
+#define ALARM_BLINK_MS 500
+#define ALARM_RING_MS 60000UL
 
 //4->celcius; 5->fahrenheit; 6->kelvin;
 uint8_t checkTemperature = 4; // keep track of the temperature measure unit
 
-//Variables used for button interface
+//Variables used for button interface (SNOOZE held for BUTTON_HOLD_MS exits a menu, UP/DOWN repeat while held)
+
+Buttons buttons;
+uint8_t snoozeButton, upButton, downButton, graphButton;
+
+enum ButtonAction : uint8_t{
+    SNOOZE_PRESS, // released before BUTTON_HOLD_MS
+    SNOOZE_HOLD,
+    SNOOZE_DOWN, // sent when pressed, before SNOOZE_PRESS or SNOOZE_HOLD
+    UP_PRESS, // also sent every BUTTON_REPEAT_MS while held
+    DOWN_PRESS,
+    GRAPH_PRESS
+};
+
+bool repeatArmed = false; // UP/DOWN repeat while held
 
-long buttonTimer = 0;
-long buttonPressTime = 700;
-bool buttonActive = false;
-bool buttonHoldActive = false;
+//The screen the sketch is in; each mode handles the buttons its own way
+
+enum Mode : uint8_t{
+    MODE_CLOCK,
+    MODE_EDIT_CLOCK,
+    MODE_EDIT_ALARM,
+    MODE_GRAPH,
+    MODE_ALARM // an alarm rings
+};
+
+Mode mode = MODE_CLOCK;
+unsigned long messageTimer = 0; // the screen is left alone until then
+
+//the ringing alarm
+uint8_t ringingAlarm = 0; // 0 -> no alarm rings
+RTCalarm ringingTime;
+Mode ringingFrom = MODE_CLOCK; // the mode to return to
+unsigned long ringTimer = 0;
+bool blinkOn = false;
+
+//cursor of the edit menus
+uint8_t cursorColPosition = 0; // 0 - 15
+uint8_t cursorRowPosition = 0; // 0 - 1
+uint8_t timesPressed = 1;
+uint8_t editedAlarm = 1;
+RTCalarm alarmTime; // the alarm being edited, as displayed
+
+//time shown on the clock screen, read by the clock task
+RTCdata clockTime;
+int16_t clockTemperature = 0;
 
 
 //Custom characters for alarm status
@@ -161,226 +227,157 @@ byte kelvin[8]{
 
 LiquidCrystal lcd(RS_pin,E_pin,D4_pin,D5_pin,D6_pin,D7_pin);
 
+//every screen is drawn into the frame, flush() sends the characters that changed
+
+LcdFrame frame(lcd);
+
 //instantiating RTC object
 
 DS3231 rtc;
+//snooze of the ignored alarms; keeps the alarm that was set in RAM
+SnoozeManager snooze(rtc);
 
-bool greater9(uint8_t value){
-    return value > 9;
-}
+//instantiating the task scheduler and the ids of the tasks
 
-bool isLeapYear(uint8_t year){
-    if((year + 2000) % 400 == 0)
-        return true;
-    if((year + 2000) % 100 == 0)
-        return false;
-    if((year + 2000) % 4 == 0)
-        return true;
+Scheduler scheduler;
+uint8_t clockTask, alarmTask, ringTask, inputTask, displayTask, eepromTask;
 
-    return false;
+bool greater9(uint8_t value){
+    return value > 9;
 }
 
 //used for printing values in 0X format
 void print0X2LCD(uint8_t value){
     if(greater9(value)){
-        lcd.print(value);
+        frame.print(value);
     }
     else{
-        lcd.print(0);
-        lcd.print(value);
+        frame.print(0);
+        frame.print(value);
     }
 }
-// prints the time to the lcd display
+// prints the time last read by the clock task to the lcd display
 void printTime2LCD(){
-    //lcd.clear();
-    RTCdata clockTime = rtc.readTime();
-    lcd.setCursor(0,0);
-    print0X2LCD(clockTime.hour);
-    lcd.print(':');
-    print0X2LCD(clockTime.minutes);
-    lcd.print(":");
-    print0X2LCD(clockTime.seconds);
+    int16_t temperature = clockTemperature;
+    frame.clear(); // only the cells that changed are sent
+    frame.setCursor(0,0);
+    print0X2LCD(clockTime.hour());
+    frame.print(':');
+    print0X2LCD(clockTime.minutes());
+    frame.print(":");
+    print0X2LCD(clockTime.seconds());
     //print temperature ---> change later to print different temp
+    //fixed point all the way, the refresh runs no floating point code
+    char text[8];
     switch (checkTemperature) {
         case CELCIUS: // celcius
-            lcd.print("  ");
-            lcd.print(rtc.readCelcius());
-            lcd.write(byte(CELCIUS));
+            frame.print("  ");
+            DS3231::formatCenti(DS3231::quarterToCentiCelcius(temperature), text);
+            frame.print(text);
+            frame.write(byte(CELCIUS));
             break;
         case FAHRENHEIT: // fahrenheit
-            lcd.print("  ");
-            lcd.print(rtc.readFahrenheit());
-            lcd.write(byte(FAHRENHEIT));
+            frame.print("  ");
+            DS3231::formatCenti(DS3231::quarterToCentiFahrenheit(temperature), text);
+            frame.print(text);
+            frame.write(byte(FAHRENHEIT));
             break;
         case KELVIN: // kelvin
-            lcd.print(" ");
-            lcd.print(rtc.readKelvin());
-            lcd.write(byte(KELVIN));
+            frame.print(" ");
+            DS3231::formatCenti(DS3231::quarterToCentiKelvin(temperature), text);
+            frame.print(text);
+            frame.write(byte(KELVIN));
             break;
     }
     //start printing on the next row
-    lcd.setCursor(0,1);
+    frame.setCursor(0,1);
     //prints the day
-    lcd.print(DS3231::dayStr(clockTime.day));
-    lcd.print(' ');
-    print0X2LCD(clockTime.date);
-    lcd.print('/');
-    print0X2LCD(clockTime.month);
-    lcd.print('/');
-    lcd.print(clockTime.year);
+    frame.print(DS3231::dayStr(clockTime.day()));
+    frame.print(' ');
+    print0X2LCD(clockTime.date());
+    frame.print('/');
+    print0X2LCD(clockTime.month());
+    frame.print('/');
+    frame.print(clockTime.year());
     //TEST CUSTOM CHARACTERS ---> DELETE LATER
-    lcd.write(byte(ASymbol));
+    frame.write(byte(ASymbol));
     if(rtc.alarmState(1) && rtc.alarmState(2)){ // both alarms enabled
-        lcd.write(byte(BothON));
+        frame.write(byte(BothON));
     }
     else if(rtc.alarmState(1) && !rtc.alarmState(2)){ // alarm 1 enabled and alarm 2 disabled
-        lcd.write(byte(A1ON));
+        frame.write(byte(A1ON));
     }
     else if(!rtc.alarmState(1) && rtc.alarmState(2)){ // alarm 1 disabled and alarm 2 enabled
-        lcd.write(byte(A2ON));
+        frame.write(byte(A2ON));
     }
     else{ // no alarm enabled
-        lcd.print("-");
+        frame.print("-");
     }
+    frame.flush();
 }
 
+
 //prints the blinking alarm to the lcd
 void printALarm2LCD(RTCalarm &alarm){
-    lcd.clear();
-    lcd.setCursor(6,0);
+    frame.clear();
+    frame.setCursor(6,0);
     print0X2LCD(alarm.hour);
-    lcd.print(":");
+    frame.print(":");
     print0X2LCD(alarm.minutes);
-    lcd.setCursor(6,1);
-    lcd.print("ALARM!");
-    delay(500);
-    lcd.clear();
-    delay(500);
+    frame.setCursor(6,1);
+    frame.print("ALARM!");
+    frame.flush();
 }
 
 //prints alarm information to the lcd
 void displayAlarm2LCD(RTCalarm &alarm){
     lcd.noBlink();
-    lcd.clear();
-    lcd.setCursor(4,0);
+    frame.clear();
+    frame.setCursor(4,0);
     print0X2LCD(alarm.hour);
-    lcd.print(":");
+    frame.print(":");
     print0X2LCD(alarm.minutes);
-    lcd.print(" ");
+    frame.print(" ");
     if(alarm.enabled)
-        lcd.print("ON");
+        frame.print("ON");
     else
-        lcd.print("OFF");
-    lcd.setCursor(6,1);
-    lcd.print(DS3231::dayStr(alarm.day));
-}
-
-//is called when the alarm condition is met
-void alarm(uint8_t alarmNumber){
-    uint8_t passedSeconds = 0;
-    lcd.noCursor();
-    lcd.noBlink();
-    RTCalarm alarm = rtc.readAlarm(alarmNumber);
-    rtc.toggleSQW(true); // make LED blink while alarm is ringing
-    while(digitalRead(SNOOZE_pin) == LOW && passedSeconds < 60){
-        tone(BUZZ_pin,1245,500);
-        printALarm2LCD(alarm);
-        passedSeconds++;
-    }
-    if(passedSeconds >= 60 && !alarmIgnored[alarmNumber-1]){
-        rtc.storeAlarmEEPROM(alarmNumber); // store current alarm in the memory
-        alarmIgnored[alarmNumber-1] = true; // alarm was ignored
-    }
-    if(passedSeconds >= 60 && alarmIgnored[alarmNumber-1]){
-        //sets new alarm to trigger 5 min from now;
-        alarmIgnoredCount[alarmNumber-1]++;
-        alarm.minutes += 5;
-        if(alarm.minutes > 59){
-            alarm.minutes %= 60;
-            alarm.hour++;
-            if(alarm.hour > 23){
-                alarm.hour %= 24;
-                if(alarm.day != DAILY){
-                    uint8_t value = (uint8_t)alarm.day + 1;
-                    if(value == 8)
-                        alarm.day = (dayOfWeek)1;
-                    else
-                        alarm.day = (dayOfWeek)value;
-                }
-            }
-        }
-        if(alarm.day == DAILY){
-            rtc.setAlarmDaily(alarmNumber, alarm.hour, alarm.minutes);
-        }
-        else{
-            rtc.setAlarmWeekly(alarmNumber,alarm.hour,alarm.minutes,alarm.day);
-        }
-    }
-    if(passedSeconds < 60 && alarmIgnoredCount[alarmNumber-1]){
-        alarmIgnored[alarmNumber-1] = false; // alarm was ignored before, but not this time
-        alarmIgnoredCount[alarmNumber-1] = 0;
-        // restore the alarm that was stored in the memory
-        alarm = rtc.readAlarmEEPROM(alarmNumber);
-        if(alarm.day == DAILY){
-            rtc.setAlarmDaily(alarmNumber, alarm.hour, alarm.minutes);
-        }
-        else{
-            rtc.setAlarmWeekly(alarmNumber,alarm.hour,alarm.minutes,alarm.day);
-        }
-    }
-    if(passedSeconds < 60 && !alarmIgnoredCount[alarmNumber-1]){
-        //alarm was disabled correctly;
-    }
-    //if it was ignored 5 times in a row, ignore the alarm and restore the one stored in the memory
-    if(alarmIgnoredCount[alarmNumber-1] == 5){
-        alarmIgnored[alarmNumber-1] = false;
-        alarmIgnoredCount[alarmNumber-1] = 0;
-        // restore the alarm that was stored in the memory
-        alarm = rtc.readAlarmEEPROM(alarmNumber);
-        if(alarm.day == DAILY){
-            rtc.setAlarmDaily(alarmNumber, alarm.hour, alarm.minutes);
-        }
-        else{
-            rtc.setAlarmWeekly(alarmNumber,alarm.hour,alarm.minutes,alarm.day);
-        }
-    }
-    rtc.toggleSQW(false); // turn off SQW
-    rtc.snoozeAlarm(); // disable alarm flags
-    AlarmState = false; // disable the interrupt variable
+        frame.print("OFF");
+    frame.setCursor(6,1);
+    frame.print(DS3231::dayStr(alarm.day));
+    frame.flush();
 }
 
 //is called to change clock values
 // 1-hour; 2-minutes; 3-temperature measure unit;
-// 4-DOW, 5-date; 6-month; 7-year;
-void changeValue(uint8_t changeItem){
+// 5-date; 6-month; 7-year; (the day of week follows the date)
+void changeValue(uint8_t changeItem, bool up){
     uint8_t value = 1;
-    RTCdata time = rtc.readTime();
-    uint8_t maxDays;
-    if(isLeapYear(time.year)){
-        maxDays = leapYear[time.month-1];
-    }
-    else maxDays = normalYear[time.month-1];
+    RTCdata now = rtc.readTime();
+    uint8_t hour = now.hour(), minutes = now.minutes(), date = now.date();
+    uint8_t month = now.month();
+    uint16_t year = now.year();
+    uint8_t maxDays = DS3231::daysInMonth(year, month);
     /*
      * setTime method:
      * 0 -> change hour; 1 -> change minutes; 2 -> change seconds;
      * setDate method:
-     * 0 -> change day; 1 -> change date; 2 -> change month; 3 -> change year;
+     * 1 -> change date; 2 -> change month; 3 -> change year;
      */
-    if(digitalRead(UP_pin)){
+    if(up){
         switch (changeItem) {
             case 1:
-                if (time.hour + value == 24) {
-                    time.hour = 0;
-                    rtc.setTime(0, time.hour);
+                if (hour + value == 24) {
+                    hour = 0;
+                    rtc.setTime(0, hour);
                 } else {
-                    rtc.setTime(0, time.hour + value);
+                    rtc.setTime(0, hour + value);
                 }
                 break;
             case 2:
-                if (time.minutes + value == 60) {
-                    time.minutes = 0;
-                    rtc.setTime(1, time.minutes);
-                } else rtc.setTime(1, time.minutes + value);
+                if (minutes + value == 60) {
+                    minutes = 0;
+                    rtc.setTime(1, minutes);
+                } else rtc.setTime(1, minutes + value);
                 break;
             case 3:
                 if(checkTemperature == KELVIN) // 6
@@ -388,38 +385,30 @@ void changeValue(uint8_t changeItem){
                 else
                     checkTemperature++;
                 break;
-            case 4:
-                //1-7
-                if ((int8_t)time.day + value == 8) {
-                    time.day = MONDAY;
-                    rtc.setDate(0, time.day);
-                } else rtc.setDate(0, time.day + value);
-                break;
             case 5:
-                if(time.date == maxDays)
+                if(date == maxDays)
                     rtc.setDate(1, 1);
-                else rtc.setDate(1,time.date + 1);
+                else rtc.setDate(1,date + 1);
                 break;
             case 6:
-                if ((int8_t)time.month == 12) {
-                    time.month = JANUARY;
-                    rtc.setDate(2, time.month);
+                if (month == 12) {
+                    month = JANUARY;
+                    rtc.setDate(2, month);
                 } else {
-                    time.month = Month((uint8_t)time.month + value);
-                    rtc.setDate(2, (int8_t)time.month);
+                    month = month + value;
+                    rtc.setDate(2, month);
                 }
-                if(isLeapYear(time.year)){
-                    maxDays = leapYear[time.month-1];
-                }
-                else maxDays = normalYear[time.month-1];
-                if(time.date > maxDays)
+                maxDays = DS3231::daysInMonth(year, month);
+                if(date > maxDays)
                     rtc.setDate(1,maxDays);
                 break;
             case 7:
-                if (time.year == 2199) {
-                    time.year = 2000;
-                    rtc.setDate(3, time.year);
-                } else rtc.setDate(3, time.year + value);
+                if (year == RTC_YEAR_MAX)
+                    year = RTC_YEAR_MIN;
+                else year += value;
+                rtc.setDate(3, year);
+                if(date > DS3231::daysInMonth(year, month)) // February 29
+                    rtc.setDate(1, DS3231::daysInMonth(year, month));
                 break;
             case 8:
                 // toggle alarm 1
@@ -430,19 +419,19 @@ void changeValue(uint8_t changeItem){
     else{
         switch (changeItem) {
             case 1:
-                if (time.hour == 0) {
-                    time.hour = 23;
-                    rtc.setTime(0, time.hour);
+                if (hour == 0) {
+                    hour = 23;
+                    rtc.setTime(0, hour);
                 } else {
-                    rtc.setTime(0, time.hour - value);
+                    rtc.setTime(0, hour - value);
                 }
                 break;
             case 2:
-                if (time.minutes == 0) {
-                    time.minutes = 59;
-                    rtc.setTime(1, time.minutes);
+                if (minutes == 0) {
+                    minutes = 59;
+                    rtc.setTime(1, minutes);
                 }
-                else rtc.setTime(1, time.minutes - value);
+                else rtc.setTime(1, minutes - value);
                 break;
             case 3:
                 if(checkTemperature == CELCIUS) // 6
@@ -450,41 +439,31 @@ void changeValue(uint8_t changeItem){
                 else
                     checkTemperature--;
                 break;
-            case 4:
-                //1-7
-                if ((int8_t) time.day  == 1) {
-                    time.day = SUNDAY;
-                    rtc.setDate(0, time.day);
-                }
-                else rtc.setDate(0, (int8_t)time.day - value);
-                break;
             case 5:
-                if(time.date == 1)
+                if(date == 1)
                     rtc.setDate(1, maxDays);
-                else rtc.setDate(1,time.date - 1);
+                else rtc.setDate(1,date - 1);
                 break;
             case 6:
-                if ((int8_t) time.month == 1) {
-                    time.month = DECEMBER;
-                    rtc.setDate(2, time.month);
+                if (month == 1) {
+                    month = DECEMBER;
+                    rtc.setDate(2, month);
                 }
                 else {
-                    time.month = Month((uint8_t)time.month - value);
-                    rtc.setDate(2, (int8_t)time.month);
+                    month = month - value;
+                    rtc.setDate(2, month);
                 }
-                if(isLeapYear(time.year)){
-                    maxDays = leapYear[time.month-1];
-                }
-                else maxDays = normalYear[time.month-1];
-                if(time.date > maxDays)
+                maxDays = DS3231::daysInMonth(year, month);
+                if(date > maxDays)
                     rtc.setDate(1,maxDays);
                 break;
             case 7:
-                if (time.year == 2000) {
-                    time.year = 2199;
-                    rtc.setDate(3, time.year);
-                }
-                else rtc.setDate(3, time.year - value);
+                if (year == RTC_YEAR_MIN)
+                    year = RTC_YEAR_MAX;
+                else year -= value;
+                rtc.setDate(3, year);
+                if(date > DS3231::daysInMonth(year, month)) // February 29
+                    rtc.setDate(1, DS3231::daysInMonth(year, month));
                 break;
             case 8:
                 //toggle alarm2;
@@ -492,108 +471,18 @@ void changeValue(uint8_t changeItem){
                 break;
         }
     }
-    printTime2LCD();
-    delay(200);
-}
-
-//edit interface using buttons
-void editClock(){
-    printTime2LCD();
-    uint8_t cursorColPosition = 1; // 0 - 15
-    uint8_t cursorRowPosition = 0; // 0 - 1
-    uint8_t timesPressed = 1;
-    lcd.setCursor(cursorColPosition,cursorRowPosition);
-    lcd.blink();
-    lcd.noCursor();
-    delay(200);
-    //runs until button is hold
-    while(true){
-        //check if SNOOZE button has been pressed
-        if(cursorColPosition > 15){
-            if(cursorRowPosition == 0){
-                cursorRowPosition++;
-                cursorColPosition = 2;
-            }
-            else{
-                cursorRowPosition = 0;
-                cursorColPosition = 1;
-            }
-            lcd.setCursor(cursorColPosition,cursorRowPosition);
-            //lcd.blink();
-        }
-        //***********************************
-        if(digitalRead(SNOOZE_pin) == HIGH){
-            if(buttonActive == false){
-                buttonActive = true;
-                buttonTimer = millis();
-            }
-            if((millis() - buttonTimer > buttonPressTime) && buttonHoldActive == false){
-                // button has been held down -> exit the loop
-                buttonHoldActive = false;
-                buttonActive = false;
-                lcd.clear();
-                lcd.setCursor(1,0);
-                lcd.noBlink();
-                lcd.noCursor();
-                lcd.print("EXIT EDIT MENU");
-                break;
-            }
-        }
-        else{
-            //button has only been pressed, not held down
-            if(buttonActive == true){
-                //increment the cursor / update the display
-                printTime2LCD();
-                buttonActive = false;
-                timesPressed++;
-                if(timesPressed == 9)
-                    timesPressed = 1;
-                switch (cursorRowPosition) {
-                    case 0: // cursor on the first row
-                        if(timesPressed == 3){ // on the 4th press ...
-                            cursorColPosition += 11; // jump to the temperature measure unit
-                        }
-                        else cursorColPosition += 3;
-                        break;
-                    case 1: // cursor on the second row
-                        if(timesPressed == 7){
-                            cursorColPosition += 5; // jumps to the year
-                        }
-                        else if(timesPressed == 8){
-                            cursorColPosition++; // jumps to the alarm symbol
-                            //set up alarms using 2 buttons, 1 for each alarm
-                        }
-                        else cursorColPosition += 3;
-                        break;
-                }
-            }
-        }
-        //increment or decrement the selected/blinking value;
-        if(digitalRead(UP_pin) == HIGH || digitalRead(DOWN_pin) == HIGH){
-            changeValue(timesPressed);
-        }
-        // check if alarm condition is met
-        if(AlarmState){
-            uint8_t alarmNumber = rtc.checkAlarmFlag();
-            if(alarmNumber == 0) // both alarm at the same time
-                alarmNumber = 1; // only deal with alarm 1, ignore alarm 2;
-            alarm(alarmNumber);
-            delay(700); // debounce time
-            printTime2LCD(); // update the screen since we've exited the alarm state
-        }
-        lcd.setCursor(cursorColPosition,cursorRowPosition);
-        lcd.blink();
-    }
+    // the clock task reads the new time before the screen is drawn
+    scheduler.signal(EVENT_TIME_SET | EVENT_REDRAW);
 }
 
 //
-void changeValueForAlarm(uint8_t alarmNumber, uint8_t changeItem) {
+void changeValueForAlarm(uint8_t alarmNumber, uint8_t changeItem, bool up) {
     RTCalarm alarm = rtc.readAlarm(alarmNumber);
     int8_t value, mode; // mode = 0 -> daily; mode = 1 -> weekly
     if(alarm.day == DAILY)
         mode = 0;
     else mode = 1;
-    if (digitalRead(UP_pin) == HIGH)
+    if (up)
         value = 1;
     else value = -1;
     switch (changeItem) {
@@ -638,96 +527,6 @@ void changeValueForAlarm(uint8_t alarmNumber, uint8_t changeItem) {
     }
 }
 
-//1 for alarm 1 and 2 for alarm 2
-void editAlarm(uint8_t alarmNumber){
-    RTCalarm alarmTime = rtc.readAlarm(alarmNumber);
-    uint8_t cursorColPosition = 5; // 0 - 15
-    uint8_t cursorRowPosition = 0; // 0 - 1
-    uint8_t timesPressed = 1;
-    displayAlarm2LCD(alarmTime);
-    lcd.setCursor(cursorColPosition,cursorRowPosition);
-    lcd.blink();
-    lcd.noCursor();
-    delay(200);
-    while(true){
-        //***********************************
-        if(digitalRead(SNOOZE_pin) == HIGH){
-            if(buttonActive == false){
-                buttonActive = true;
-                buttonTimer = millis();
-            }
-            if((millis() - buttonTimer > buttonPressTime) && buttonHoldActive == false){
-                // button has been held down -> exit the loop
-                buttonHoldActive = false;
-                buttonActive = false;
-                lcd.clear();
-                lcd.setCursor(1,0);
-                lcd.noBlink();
-                lcd.noCursor();
-                lcd.print("EXIT EDIT MENU");
-                break;
-            }
-        }
-        else{
-            //button has only been pressed, not held down
-            if(buttonActive == true){
-                //increment the cursor / update the display
-                buttonActive = false;
-                timesPressed++;
-                switch (timesPressed) {
-                    case 2:
-                        cursorColPosition += 3;
-                        break;
-                    case 3:
-                        if(!alarmTime.enabled)
-                            cursorColPosition += 4;
-                        else cursorColPosition += 3;
-                        break;
-                    case 4: // next row
-                        if(alarmTime.day == DAILY)
-                            cursorColPosition = 10;
-                        else cursorColPosition = 8;
-                        cursorRowPosition = 1;
-                        break;
-                    case 5:
-                        timesPressed = 1; // restart the cycle;
-                        cursorRowPosition = 0;
-                        cursorColPosition = 5;
-                        break;
-                }
-            }
-        }
-        if(digitalRead(UP_pin) == HIGH || digitalRead(DOWN_pin) == HIGH){
-            changeValueForAlarm(alarmNumber, timesPressed);
-            alarmTime = rtc.readAlarm(alarmNumber); // update alarmTime
-            if(timesPressed == 3 && cursorColPosition == 12)
-                cursorColPosition--;
-            else if(timesPressed == 3 && cursorColPosition == 11)
-                cursorColPosition++;
-            if(timesPressed == 4 && cursorColPosition == 10)
-                cursorColPosition -= 2;
-            else if(timesPressed == 4 && alarmTime.day == DAILY)
-                cursorColPosition += 2;
-            displayAlarm2LCD(alarmTime);
-            delay(200);
-        }
-        if(AlarmState){
-            uint8_t alarmNumber = rtc.checkAlarmFlag();
-            if(alarmNumber == 0) // both alarmTime at the same time
-                alarmNumber = 1; // only deal with alarmTime 1, ignore alarmTime 2;
-            alarm(alarmNumber);
-            displayAlarm2LCD(alarmTime);
-            delay(700); // debounce time
-        }
-        lcd.setCursor(cursorColPosition,cursorRowPosition);
-        lcd.blink();
-    }
-    // When editing the alarm, it counts as not ignored!
-    alarmIgnored[alarmNumber-1] = false;
-    alarmIgnoredCount[alarmNumber-1] = 0;
-    rtc.storeAlarmEEPROM(alarmNumber);
-}
-
 void restoreCharacters() {
     lcd.createChar(ASymbol,alarmSymbol);
     lcd.createChar(A1ON,alarm1ON);
@@ -739,29 +538,18 @@ void restoreCharacters() {
     lcd.setCursor(0,0);
 }
 
-uint8_t getTmpBarLevel(float temperature) {
-    if(temperature >= 0 && temperature < 5)
+// temperature in 0.25 Celcius steps; one level every 5 degrees
+uint8_t getTmpBarLevel(int16_t temperature) {
+    if(temperature < 0)
         return 0;
-    if(temperature >= 5 && temperature < 10)
-        return 1;
-    if(temperature >= 10 && temperature < 15)
-        return 2;
-    if(temperature >= 15 && temperature < 20)
-        return 3;
-    if(temperature >= 20 && temperature < 25)
-        return 4;
-    if(temperature >= 25 && temperature < 30)
-        return 5;
-    if(temperature >= 30 && temperature < 35)
-        return 6;
-    if(temperature >= 35)
+    if(temperature >= 35 * 4)
         return 7;
-    return 0;
+    return temperature / (5 * 4);
 }
 
-void createTmpGraph(float* temperatures) {
-    lcd.clear();
-    lcd.setCursor(0,0);
+void createTmpGraph(int16_t* temperatures) {
+    frame.clear();
+    frame.setCursor(0,0);
     rtc.readLast24hTemperature(temperatures);
     int8_t tempIndex = 23;
     for (uint8_t i = 0; i < 8; i++) {
@@ -773,64 +561,384 @@ void createTmpGraph(float* temperatures) {
             }
         }
         lcd.createChar(i, character);
-        lcd.setCursor(i, 1);
-        lcd.write(i);
+        frame.setCursor(i, 1);
+        frame.write(i);
     }
-    lcd.setCursor(0, 0);
-    lcd.print("Temp (last 24h)");
+    frame.setCursor(0, 0);
+    frame.print("Temp (last 24h)");
+    frame.flush();
 }
 
-void editGraph() {
-    float temperatures[24];
-    createTmpGraph(temperatures);
-    while(true) {
-        //***********************************
-        if (digitalRead(SNOOZE_pin) == HIGH) {
-            if (buttonActive == false) {
-                buttonActive = true;
-                buttonTimer = millis();
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                                  MODES
+ ---------------------------------------------------------------------------------------------------------------------*/
+
+// leaves a menu: the message stays for MESSAGE_MS, then the clock screen is drawn
+void exitMenu(const char* message){
+    frame.clear();
+    frame.setCursor(1,0);
+    lcd.noBlink();
+    lcd.noCursor();
+    frame.print(message);
+    frame.flush();
+    mode = MODE_CLOCK;
+    repeatArmed = false;
+    messageTimer = millis() + MESSAGE_MS;
+    scheduler.runIn(displayTask, MESSAGE_MS);
+}
+
+//edit interface using buttons
+void enterEditClock(){
+    mode = MODE_EDIT_CLOCK;
+    cursorColPosition = 1;
+    cursorRowPosition = 0;
+    timesPressed = 1;
+    scheduler.signal(EVENT_REDRAW);
+}
+
+//moves the cursor of the clock menu to the next value
+void nextClockField(){
+    timesPressed++;
+    if(timesPressed == 9)
+        timesPressed = 1;
+    switch (cursorRowPosition) {
+        case 0: // cursor on the first row
+            if(timesPressed == 3){ // on the 4th press ...
+                cursorColPosition += 11; // jump to the temperature measure unit
             }
-            if ((millis() - buttonTimer > buttonPressTime) && buttonHoldActive == false) {
-                // button has been held down -> exit the loop
-                buttonHoldActive = false;
-                buttonActive = false;
-                lcd.clear();
-                lcd.setCursor(1, 0);
-                lcd.noBlink();
-                lcd.noCursor();
-                lcd.print("EXIT TMP MENU");
-                delay(500);
-                break;
+            else cursorColPosition += 3;
+            break;
+        case 1: // cursor on the second row
+            if(timesPressed == 7){
+                cursorColPosition += 5; // jumps to the year
             }
-        } else {
-            //button has only been pressed, not held down
-            if(buttonActive == true){
-                buttonActive = false;
-                createTmpGraph(temperatures);
-                delay(700);
+            else if(timesPressed == 8){
+                cursorColPosition++; // jumps to the alarm symbol
+                //set up alarms using 2 buttons, 1 for each alarm
             }
+            else cursorColPosition += 3;
+            break;
+    }
+    if(cursorColPosition > 15){
+        if(cursorRowPosition == 0){
+            cursorRowPosition++;
+            // the day of week follows the date, the cursor skips it
+            cursorColPosition = 5;
+            timesPressed = 5;
         }
-        // check if alarm condition is met
-        if(AlarmState){
-            uint8_t alarmNumber = rtc.checkAlarmFlag();
-            if(alarmNumber == 0) // both alarm at the same time
-                alarmNumber = 1; // only deal with alarm 1, ignore alarm 2;
-            alarm(alarmNumber);
-            delay(700); // debounce time
-            //printTime2LCD(); // update the screen since we've exited the alarm state
-            restoreCharacters();
-            lcd.clear();
-            return;
+        else{
+            cursorRowPosition = 0;
+            cursorColPosition = 1;
         }
-        rtc.readTime();
     }
-    lcd.home();
-    lcd.clear();
+    scheduler.signal(EVENT_REDRAW);
+}
+
+//1 for alarm 1 and 2 for alarm 2
+void enterEditAlarm(uint8_t alarmNumber){
+    mode = MODE_EDIT_ALARM;
+    editedAlarm = alarmNumber;
+    alarmTime = rtc.readAlarm(alarmNumber);
+    cursorColPosition = 5;
+    cursorRowPosition = 0;
+    timesPressed = 1;
+    scheduler.signal(EVENT_REDRAW);
+}
+
+//moves the cursor of the alarm menu to the next value
+void nextAlarmField(){
+    timesPressed++;
+    switch (timesPressed) {
+        case 2:
+            cursorColPosition += 3;
+            break;
+        case 3:
+            if(!alarmTime.enabled)
+                cursorColPosition += 4;
+            else cursorColPosition += 3;
+            break;
+        case 4: // next row
+            if(alarmTime.day == DAILY)
+                cursorColPosition = 10;
+            else cursorColPosition = 8;
+            cursorRowPosition = 1;
+            break;
+        case 5:
+            timesPressed = 1; // restart the cycle;
+            cursorRowPosition = 0;
+            cursorColPosition = 5;
+            break;
+    }
+    scheduler.signal(EVENT_REDRAW);
+}
+
+void changeAlarmField(bool up){
+    changeValueForAlarm(editedAlarm, timesPressed, up);
+    alarmTime = rtc.readAlarm(editedAlarm); // update alarmTime
+    if(timesPressed == 3 && cursorColPosition == 12)
+        cursorColPosition--;
+    else if(timesPressed == 3 && cursorColPosition == 11)
+        cursorColPosition++;
+    if(timesPressed == 4 && cursorColPosition == 10)
+        cursorColPosition -= 2;
+    else if(timesPressed == 4 && alarmTime.day == DAILY)
+        cursorColPosition += 2;
+    scheduler.signal(EVENT_REDRAW);
+}
+
+void exitEditAlarm(){
+    // When editing the alarm, it counts as not ignored!
+    snooze.reset(editedAlarm);
+    rtc.storeAlarmEEPROM(editedAlarm);
+    exitMenu("EXIT EDIT MENU");
+}
+
+void enterGraph(){
+    mode = MODE_GRAPH;
+    int16_t temperatures[24];
+    createTmpGraph(temperatures);
+}
+
+void exitGraph(){
+    exitMenu("EXIT TMP MENU");
     restoreCharacters();
 }
 
+// the buttons held now were used by someone else (the alarm): their release is not a press
+void ignoreHeldButtons(){
+    buttons.ignoreHeld();
+    repeatArmed = false;
+}
+
+//starts ringing alarm alarmNumber; the ring task does the rest
+void startAlarm(uint8_t alarmNumber){
+    ringingAlarm = alarmNumber;
+    ringingTime = rtc.readAlarm(alarmNumber);
+    ringingFrom = mode;
+    mode = MODE_ALARM;
+    ringTimer = millis();
+    blinkOn = false;
+    lcd.noCursor();
+    lcd.noBlink();
+#if !SOFT_CLOCK_RESYNC
+    rtc.toggleSQW(true); // make LED blink while alarm is ringing
+#endif
+    scheduler.enable(ringTask, true);
+    scheduler.runIn(ringTask, 0); // the first ring starts now
+}
+
+//stops the ringing alarm; ignored -> nobody pressed SNOOZE for ALARM_RING_MS
+void stopAlarm(bool ignored){
+    uint8_t alarmNumber = ringingAlarm;
+    scheduler.enable(ringTask, false);
+    noTone(BUZZ_pin);
+    //ignored -> rings again 5 min after it rang, or the alarm that was set after 5 times in a row;
+    //stopped -> the alarm that was set is restored if it was snoozed
+    if(ignored)
+        snooze.ignored(alarmNumber);
+    else
+        snooze.stopped(alarmNumber);
+#if !SOFT_CLOCK_RESYNC
+    rtc.toggleSQW(false); // turn off SQW
+#endif
+    rtc.snoozeAlarm(); // disable alarm flags
+    ringingAlarm = 0;
+    if(ringingFrom == MODE_GRAPH){
+        restoreCharacters();
+        mode = MODE_CLOCK;
+    }
+    else mode = ringingFrom;
+    ignoreHeldButtons(); // SNOOZE stopped the alarm
+    scheduler.signal(EVENT_TIME_SET | EVENT_REDRAW); // update the screen since we've exited the alarm state
+}
+
+//what a button does in the current mode
+void onButton(ButtonAction action){
+    switch (mode) {
+        case MODE_CLOCK:
+            if(action == SNOOZE_PRESS)
+                enterEditClock();
+            else if(action == UP_PRESS)
+                enterEditAlarm(1); // edit alarm1
+            else if(action == DOWN_PRESS)
+                enterEditAlarm(2); // edit alarm2
+            else if(action == GRAPH_PRESS)
+                enterGraph();
+            break;
+        case MODE_EDIT_CLOCK:
+            if(action == SNOOZE_PRESS)
+                nextClockField();
+            else if(action == SNOOZE_HOLD)
+                exitMenu("EXIT EDIT MENU");
+            else if(action == UP_PRESS || action == DOWN_PRESS)
+                changeValue(timesPressed, action == UP_PRESS);
+            break;
+        case MODE_EDIT_ALARM:
+            if(action == SNOOZE_PRESS)
+                nextAlarmField();
+            else if(action == SNOOZE_HOLD)
+                exitEditAlarm();
+            else if(action == UP_PRESS || action == DOWN_PRESS)
+                changeAlarmField(action == UP_PRESS);
+            break;
+        case MODE_GRAPH:
+            if(action == SNOOZE_PRESS){
+                int16_t temperatures[24];
+                createTmpGraph(temperatures);
+            }
+            else if(action == SNOOZE_HOLD)
+                exitGraph();
+            break;
+        case MODE_ALARM: // the other buttons do nothing while the alarm rings
+            if(action == SNOOZE_DOWN)
+                stopAlarm(false);
+            break;
+    }
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                                  TASKS
+ ---------------------------------------------------------------------------------------------------------------------*/
+
+// when a button pin changed or a button is due for a hold or repeat: turns the button events into actions
+void inputTaskRun(){
+    ButtonEvent event;
+    while(buttons.next(event)){
+        if(event.button == snoozeButton){
+            if(event.type == BUTTON_PRESSED)
+                onButton(SNOOZE_DOWN);
+            else if(event.type == BUTTON_CLICKED)
+                onButton(SNOOZE_PRESS); //button has only been pressed, not held down
+            else if(event.type == BUTTON_HELD)
+                onButton(SNOOZE_HOLD); // button has been held down
+        }
+        else if(event.button == upButton || event.button == downButton){
+            ButtonAction action = event.button == upButton ? UP_PRESS : DOWN_PRESS;
+            if(event.type == BUTTON_PRESSED){
+                Mode before = mode;
+                onButton(action);
+                repeatArmed = mode == before; // a button that opened a menu does not change values in it
+            }
+            else if(event.type == BUTTON_REPEATED && repeatArmed)
+                onButton(action);
+            else if(event.type == BUTTON_RELEASED)
+                repeatArmed = false;
+        }
+        else if(event.button == graphButton && event.type == BUTTON_PRESSED)
+            onButton(GRAPH_PRESS);
+    }
+    uint32_t wait = buttons.nextDeadline();
+    if(wait != BUTTONS_NO_DEADLINE)
+        scheduler.runIn(inputTask, wait < 0xFFFF ? wait : 0xFFFF);
+}
+
+// every second (square wave) or every CLOCK_POLL_MS: reads the time, which also samples the temperature
+void clockTaskRun(){
+#if SOFT_CLOCK_RESYNC
+    // no I2C traffic unless a minute has passed or the clock is due for a re-sync
+    RTCdata now = rtc.softTime();
+    clockTemperature = rtc.lastTemperature();
+    // INT/SQW carries the square wave, the alarm matches are detected by the software clock
+    if(rtc.alarmPending())
+        scheduler.signal(EVENT_ALARM);
+#else
+    // one burst read gives the time and the temperature
+    RTCsnapshot snapshot = rtc.readSnapshot();
+    RTCdata now = snapshot.time;
+    clockTemperature = snapshot.temperature;
+#endif
+    if(now != clockTime){
+        clockTime = now;
+        if(mode == MODE_CLOCK || mode == MODE_EDIT_CLOCK) // the screens that show the time
+            scheduler.signal(EVENT_REDRAW);
+    }
+}
+
+// when the alarm interrupt or the software clock reports an alarm
+void alarmTaskRun(){
+    if(ringingAlarm)
+        return; // its flags are cleared when it stops
+    uint8_t alarmNumber = rtc.checkAlarmFlag();
+    if(alarmNumber == 3){ // no flag is set
+        rtc.snoozeAlarm();
+        return;
+    }
+    if(alarmNumber == 0) // both alarm at the same time
+        alarmNumber = 1; // only deal with alarm 1, ignore alarm 2;
+    startAlarm(alarmNumber);
+}
+
+// every ALARM_BLINK_MS while an alarm rings: blinks the screen, rings every other time, gives up after ALARM_RING_MS
+void ringTaskRun(){
+    if(millis() - ringTimer >= ALARM_RING_MS){
+        stopAlarm(true);
+        return;
+    }
+    blinkOn = !blinkOn;
+    if(blinkOn){
+        tone(BUZZ_pin,1245,ALARM_BLINK_MS);
+        printALarm2LCD(ringingTime);
+    }
+    else{
+        frame.clear();
+        frame.flush();
+    }
+}
+
+// when the screen of the current mode is out of date
+void displayTaskRun(){
+    if((long)(millis() - messageTimer) < 0)
+        return; // a message is shown
+    switch (mode) {
+        case MODE_CLOCK:
+            printTime2LCD();
+            break;
+        case MODE_EDIT_CLOCK:
+            printTime2LCD();
+            lcd.setCursor(cursorColPosition,cursorRowPosition);
+            lcd.blink();
+            break;
+        case MODE_EDIT_ALARM:
+            displayAlarm2LCD(alarmTime);
+            lcd.setCursor(cursorColPosition,cursorRowPosition);
+            lcd.blink();
+            break;
+        case MODE_GRAPH:
+        case MODE_ALARM:
+            break; // drawn by createTmpGraph() / the ring task
+    }
+}
+
+// every 5 ms while writes are queued: writes queued EEPROM pages without waiting for the write cycles
+void eepromTaskRun(){
+    if(!rtc.eepromIdle())
+        rtc.poll();
+}
+
+// falling edge of INT/SQW
 void _ISR(){
-    AlarmState = true;
+#if SOFT_CLOCK_RESYNC
+    rtc.tick(); // falling edge of the 1Hz square wave
+    scheduler.signal(EVENT_SECOND);
+#else
+    scheduler.signal(EVENT_ALARM);
+#endif
+}
+
+//pin change interrupts: PCINT1 -> A0 (GRAPH); PCINT2 -> D2 (INT/SQW), D3 - D5 (DOWN, UP, SNOOZE)
+//INT/SQW is watched by a pin change interrupt instead of INT0: an edge on INT0 does not wake a powered down MCU
+ISR(PCINT1_vect){
+    if(buttons.capture())
+        scheduler.signal(EVENT_BUTTON);
+}
+
+ISR(PCINT2_vect){
+    bool level = digitalRead(INT_pin);
+    if(intLevel && !level)
+        _ISR();
+    intLevel = level;
+    if(buttons.capture())
+        scheduler.signal(EVENT_BUTTON);
 }
 
 void setup(){
@@ -839,53 +947,46 @@ void setup(){
     lcd.begin(16,2);
     //disable all pins that might cause alarm interrupts ---> might change this later
     rtc.begin();
+#if SOFT_CLOCK_RESYNC
+    rtc.beginSoftClock(SOFT_CLOCK_RESYNC);
+#endif
     pinMode(INT_pin,INPUT);
-    attachInterrupt(digitalPinToInterrupt(2),_ISR,FALLING); // activating the interrupt when going from high to low
+    intLevel = digitalRead(INT_pin);
+    *digitalPinToPCMSK(INT_pin) |= _BV(digitalPinToPCMSKbit(INT_pin)); // interrupt on every change of INT/SQW
+    *digitalPinToPCICR(INT_pin) |= _BV(digitalPinToPCICRbit(INT_pin));
     pinMode(SNOOZE_pin,INPUT);
     pinMode(UP_pin,INPUT);
     pinMode(DOWN_pin,INPUT);
     pinMode(BUZZ_pin,OUTPUT);
     pinMode(GRAPH_pin, INPUT);
+    snoozeButton = buttons.add(SNOOZE_pin, false, false);
+    upButton = buttons.add(UP_pin, false, true);
+    downButton = buttons.add(DOWN_pin, false, true);
+    graphButton = buttons.add(GRAPH_pin, true, false); // active LOW
+    buttons.begin();
     //create custom characters (up to 8 characters)
-    lcd.createChar(ASymbol,alarmSymbol);
-    lcd.createChar(A1ON,alarm1ON);
-    lcd.createChar(A2ON,alarm2ON);
-    lcd.createChar(BothON,bothAlarms);
-    lcd.createChar(CELCIUS,celcius);
-    lcd.createChar(FAHRENHEIT,fahrenheit);
-    lcd.createChar(KELVIN,kelvin);
+    restoreCharacters();
+    //the tasks run in this order when they are due in the same pass
+#if SOFT_CLOCK_RESYNC
+    clockTask = scheduler.addTask(clockTaskRun, 0, EVENT_SECOND | EVENT_TIME_SET);
+#else
+    clockTask = scheduler.addTask(clockTaskRun, CLOCK_POLL_MS, EVENT_TIME_SET);
+#endif
+    alarmTask = scheduler.addTask(alarmTaskRun, 0, EVENT_ALARM);
+    ringTask = scheduler.addTask(ringTaskRun, ALARM_BLINK_MS, 0);
+    scheduler.enable(ringTask, false); // started by an alarm
+    inputTask = scheduler.addTask(inputTaskRun, 0, EVENT_BUTTON);
+    displayTask = scheduler.addTask(displayTaskRun, 0, EVENT_REDRAW);
+    eepromTask = scheduler.addTask(eepromTaskRun, 5, 0);
+    scheduler.enable(eepromTask, false); // enabled by loop() while writes are queued
+    scheduler.signal(EVENT_TIME_SET);
 }
 
 void loop(){
-    //alarm condition is met
-    if(AlarmState){
-        uint8_t alarmNumber = rtc.checkAlarmFlag();
-        if(alarmNumber == 0) // both alarm at the same time
-            alarmNumber = 1; // only deal with alarm 1, ignore alarm 2;
-        alarm(alarmNumber);
-        delay(700); // debounce time
-    }
-    // enter edit mode
-    if(digitalRead(SNOOZE_pin) == HIGH){
-        editClock();
-        delay(500); // debounce time
-    }
-
-    // edit alarm1
-    if(digitalRead(UP_pin) == HIGH){
-        editAlarm(1);
-        delay(500);
-    }
-
-    //edit alarm2
-    if(digitalRead(DOWN_pin) == HIGH){
-        editAlarm(2);
-        delay(500);
-    }
-    if(digitalRead(GRAPH_pin) == LOW) {
-        editGraph();
-        delay(500);
-    }
-    //enter SWQ edit mode
-    printTime2LCD();
-}
\ No newline at end of file
+    scheduler.runPending();
+    scheduler.enable(eepromTask, !rtc.eepromIdle());
+#if LOW_POWER
+    //powered down millis() stops, so only while no task waits for a timer; INT/SQW and the buttons wake the MCU
+    scheduler.sleep(scheduler.idleMillis() == SCHEDULER_NO_TIMER && rtc.sleepReady());
+#endif
+}
@@ -1,39 +1,415 @@
 //
 // Created by micup on 2/1/2021.
 //
+// Benchmark harness shared by the AVR bench board and host builds.
+//
+// PerfClock is the time base: on AVR Timer1 runs free with PERF_TIMER_PRESCALER and its overflow interrupt extends
+// the count to 32 bits (268 s at 16 MHz without prescaler), on the host it is std::chrono::steady_clock, or micros()
+// with PERF_CLOCK_MICROS: on the simulator (test/sim) that is simulated time, what the bus would take on a board. A
+// PerfProbe measures its scope into a PerfRun; probes nest, each one measures its own scope. A PerfRun keeps up to
+// PERF_MAX_SAMPLES samples (a uniform sample of them once more were taken) and reports min, median, p99 and max.
+// A PerfDuty adds up the awake time of a program that sleeps between interrupts.
+//
+//   PerfClock::begin();
+//   PerfRun run("readTime");
+//   run.measure(100, [&]() { rtc.readTime(); });
+//   run.report(Serial);
+//
+// On AVR the header defines the Timer1 overflow interrupt: include it from a single file of the sketch, and do not
+// use Timer1 (Servo, tone() on some boards) while benchmarking. On the host build with -Itest/sim, which provides
+// Print and Serial (test/sim/Print.cpp).
+//
 
 #ifndef DS3231_RTC_TESTPERFORMANCE_H
 #define DS3231_RTC_TESTPERFORMANCE_H
 #include <Arduino.h>
 
+#ifdef __AVR__
+
+/// Timer1 prescaler: 1, 8, 64, 256 or 1024; a tick is PERF_TIMER_PRESCALER CPU cycles
+#ifndef PERF_TIMER_PRESCALER
+#define PERF_TIMER_PRESCALER 1
+#endif
+/// samples kept by a PerfRun (4 bytes each)
+#ifndef PERF_MAX_SAMPLES
+#define PERF_MAX_SAMPLES 64
+#endif
+
+#if PERF_TIMER_PRESCALER == 1
+#define PERF_TIMER_CS _BV(CS10)
+#elif PERF_TIMER_PRESCALER == 8
+#define PERF_TIMER_CS _BV(CS11)
+#elif PERF_TIMER_PRESCALER == 64
+#define PERF_TIMER_CS (_BV(CS11) | _BV(CS10))
+#elif PERF_TIMER_PRESCALER == 256
+#define PERF_TIMER_CS _BV(CS12)
+#elif PERF_TIMER_PRESCALER == 1024
+#define PERF_TIMER_CS (_BV(CS12) | _BV(CS10))
+#else
+#error "PERF_TIMER_PRESCALER must be 1, 8, 64, 256 or 1024"
+#endif
+
+typedef uint32_t perf_ticks_t;
+
+#else
+
+#ifndef PERF_CLOCK_MICROS
+#include <chrono>
+#endif
+
+#ifndef PERF_MAX_SAMPLES
+#define PERF_MAX_SAMPLES 1024
+#endif
+
+/// nanoseconds
+typedef uint64_t perf_ticks_t;
+
+#endif
+
+/// @brief Time base of the harness.
+class PerfClock{
+public:
+    /// Starts the time base and measures the cost of an empty probe, which is subtracted from every sample.
+    static void begin() {
+#ifdef __AVR__
+        noInterrupts();
+        TCCR1A = 0;
+        TCCR1B = 0;
+        TCNT1 = 0;
+        overflows() = 0;
+        TIFR1 = _BV(TOV1); // a pending overflow is cleared by writing 1
+        TIMSK1 = _BV(TOIE1);
+        TCCR1B = PERF_TIMER_CS;
+        interrupts();
+#endif
+        overhead() = 0;
+        perf_ticks_t least = ~(perf_ticks_t)0;
+        for(uint8_t i = 0; i < 16; i++){
+            perf_ticks_t start = PerfClock::now();
+            perf_ticks_t elapsed = PerfClock::now() - start;
+            if(elapsed < least)
+                least = elapsed;
+        }
+        overhead() = least;
+    }
+
+    static perf_ticks_t now() {
+#ifdef __AVR__
+        uint8_t sreg = SREG;
+        noInterrupts();
+        uint16_t low = TCNT1;
+        uint16_t high = overflows();
+        // the counter wrapped after interrupts were disabled, the interrupt has not counted it yet
+        if((TIFR1 & _BV(TOV1)) && low < 0x8000)
+            high++;
+        SREG = sreg;
+        return (perf_ticks_t)high << 16 | low;
+#elif defined(PERF_CLOCK_MICROS)
+        return (perf_ticks_t)micros() * 1000;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    /// Converts ticks to nanoseconds, saturated at 0xFFFFFFFF (4.29 s).
+    static uint32_t toNanos(perf_ticks_t ticks) {
+#ifdef __AVR__
+        uint64_t nanos = (uint64_t)ticks * PERF_TIMER_PRESCALER * 1000000000ULL / F_CPU;
+#else
+        uint64_t nanos = ticks;
+#endif
+        return nanos > 0xFFFFFFFFULL ? 0xFFFFFFFFUL : (uint32_t)nanos;
+    }
+
+    /// Ticks of an empty measurement.
+    static perf_ticks_t& overhead() {
+        static perf_ticks_t ticks = 0;
+        return ticks;
+    }
+
+#ifdef __AVR__
+    /// Timer1 overflows, the upper half of the tick count.
+    static volatile uint16_t& overflows() {
+        static volatile uint16_t count = 0;
+        return count;
+    }
+#endif
+};
+
+#ifdef __AVR__
+ISR(TIMER1_OVF_vect) {
+    PerfClock::overflows()++;
+}
+#endif
+
+/**
+ * @brief Samples of one benchmark.
+ *
+ * min, max and mean cover every sample; median and p99 come from the kept samples, a uniform sample
+ * (reservoir) of all of them once more than PERF_MAX_SAMPLES were taken.
+ */
+class PerfRun{
+private:
+    const char* name;
+    uint16_t operations;
+    perf_ticks_t samples[PERF_MAX_SAMPLES];
+    uint16_t kept;
+    uint32_t count;
+    perf_ticks_t least;
+    perf_ticks_t most;
+    uint64_t total;
+    uint32_t seed;
+    bool sorted;
+
+    void sort() {
+        if(sorted)
+            return;
+        // insertion sort: the samples are few and often nearly in order
+        for(uint16_t i = 1; i < kept; i++){
+            perf_ticks_t sample = samples[i];
+            uint16_t j = i;
+            for(; j > 0 && samples[j - 1] > sample; j--)
+                samples[j] = samples[j - 1];
+            samples[j] = sample;
+        }
+        sorted = true;
+    }
+    uint32_t perOperation(perf_ticks_t ticks) const {
+        return PerfClock::toNanos(ticks) / operations;
+    }
+
+public:
+    /**
+     * @param name Printed by report()
+     * @param operations Operations timed by one sample; the results are per operation. Timing a batch of
+     * calls measures operations shorter than the resolution of the clock.
+     */
+    explicit PerfRun(const char* name, uint16_t operations = 1) : name(name), operations(operations ? operations : 1) {
+        reset();
+    }
+
+    void reset() {
+        kept = 0;
+        count = 0;
+        least = ~(perf_ticks_t)0;
+        most = 0;
+        total = 0;
+        seed = 1;
+        sorted = true;
+    }
+
+    /// Adds one sample, the overhead of the probe already removed.
+    void add(perf_ticks_t ticks) {
+        count++;
+        total += ticks;
+        if(ticks < least)
+            least = ticks;
+        if(ticks > most)
+            most = ticks;
+        uint16_t slot = kept;
+        if(kept == PERF_MAX_SAMPLES){
+            seed = seed * 1103515245UL + 12345UL;
+            uint32_t index = (seed >> 8) % count;
+            if(index >= PERF_MAX_SAMPLES)
+                return;
+            slot = index;
+        }
+        else kept++;
+        samples[slot] = ticks;
+        sorted = false;
+    }
+
+    /**
+     * Runs body iterations times, one sample per call.
+     * @param iterations The number of samples taken
+     * @param body Called without arguments; a batch of operations if the run times more than one per sample
+     */
+    template<typename Body>
+    void measure(uint32_t iterations, Body body);
+
+    const char* label() const { return name; }
+    uint32_t samplesTaken() const { return count; }
+    /// The results, in nanoseconds per operation; 0 if no sample was taken.
+    uint32_t minNanos() const { return count ? perOperation(least) : 0; }
+    uint32_t maxNanos() const { return count ? perOperation(most) : 0; }
+    uint32_t meanNanos() const { return count ? perOperation(total / count) : 0; }
+    uint32_t medianNanos() {
+        if(kept == 0)
+            return 0;
+        sort();
+        if(kept % 2)
+            return perOperation(samples[kept / 2]);
+        return perOperation(samples[kept / 2 - 1] + (samples[kept / 2] - samples[kept / 2 - 1]) / 2);
+    }
+    /// nearest rank: 99 % of the kept samples are at most this long
+    uint32_t p99Nanos() {
+        if(kept == 0)
+            return 0;
+        sort();
+        return perOperation(samples[(99UL * kept + 99) / 100 - 1]);
+    }
+
+    /// Prints "n":...,"min_ns":...,"median_ns":...,"p99_ns":...,"max_ns":...,"mean_ns":... to embed in a JSON object.
+    void reportJson(Print& out) {
+        out.print(F("\"n\":"));
+        out.print((unsigned long)count);
+        out.print(F(",\"min_ns\":"));
+        out.print((unsigned long)minNanos());
+        out.print(F(",\"median_ns\":"));
+        out.print((unsigned long)medianNanos());
+        out.print(F(",\"p99_ns\":"));
+        out.print((unsigned long)p99Nanos());
+        out.print(F(",\"max_ns\":"));
+        out.print((unsigned long)maxNanos());
+        out.print(F(",\"mean_ns\":"));
+        out.print((unsigned long)meanNanos());
+    }
+
+    /// Prints "name: n=... min=... median=... p99=... max=... mean=... ns" on one line.
+    void report(Print& out) {
+        out.print(name);
+        out.print(F(": n="));
+        out.print((unsigned long)count);
+        out.print(F(" min="));
+        out.print((unsigned long)minNanos());
+        out.print(F(" median="));
+        out.print((unsigned long)medianNanos());
+        out.print(F(" p99="));
+        out.print((unsigned long)p99Nanos());
+        out.print(F(" max="));
+        out.print((unsigned long)maxNanos());
+        out.print(F(" mean="));
+        out.print((unsigned long)meanNanos());
+        out.println(F(" ns"));
+    }
+};
+
+/**
+ * @brief Measures the time from its construction to the end of its scope into a PerfRun.
+ *
+ * Probes nest: an outer probe includes the inner probes' scopes, and each records its own sample.
+ */
+class PerfProbe{
+private:
+    PerfRun& run;
+    perf_ticks_t start;
+public:
+    explicit PerfProbe(PerfRun& run) : run(run) {
+        start = PerfClock::now(); // last, so the constructor is not measured
+    }
+    ~PerfProbe() {
+        perf_ticks_t elapsed = PerfClock::now() - start;
+        run.add(elapsed > PerfClock::overhead() ? elapsed - PerfClock::overhead() : 0);
+    }
+};
+
+template<typename Body>
+void PerfRun::measure(uint32_t iterations, Body body) {
+    while(iterations--){
+        PerfProbe probe(*this);
+        body();
+    }
+}
+
+/**
+ * @brief Awake time of a program that sleeps between interrupts, and the average supply current it implies.
+ *
+ * awake() is called right after the MCU wakes up, asleep() right before it sleeps again; the time between them is
+ * awake time. The length of the measurement comes from the caller: PerfClock stops while the MCU is powered down
+ * (Timer1 runs on the I/O clock), so it cannot time the sleep. The supply current is not measurable by the MCU
+ * itself: the estimate weights the currents of the awake and the sleeping MCU, given by the caller, by the awake time.
+ */
+class PerfDuty{
+private:
+    perf_ticks_t wokeAt;
+    perf_ticks_t awakeTicks;
+    uint32_t wakes;
+    bool isAwake;
+
+public:
+    PerfDuty() {
+        reset();
+    }
+
+    void reset() {
+        wokeAt = 0;
+        awakeTicks = 0;
+        wakes = 0;
+        isAwake = false;
+    }
+
+    void awake() {
+        if(isAwake)
+            return;
+        isAwake = true;
+        wakes++;
+        wokeAt = PerfClock::now();
+    }
+
+    void asleep() {
+        if(!isAwake)
+            return;
+        awakeTicks += PerfClock::now() - wokeAt;
+        isAwake = false;
+    }
+
+    uint32_t wakeCount() const { return wakes; }
+    /// Awake time in millionths of a measurement of the given length.
+    uint32_t awakePpm(uint32_t millis) const {
+        if(millis == 0)
+            return 0;
+        uint64_t nanos = (uint64_t)PerfClock::toNanos(awakeTicks);
+        uint64_t ppm = nanos / millis; // ns / (ms * 10^6) * 10^6
+        return ppm > 1000000 ? 1000000UL : (uint32_t)ppm;
+    }
+    /// Average current, in microamps, of an MCU drawing activeMicroAmps awake and sleepMicroAmps asleep.
+    uint32_t averageMicroAmps(uint32_t millis, uint32_t activeMicroAmps, uint32_t sleepMicroAmps) const {
+        uint32_t ppm = awakePpm(millis);
+        return (uint32_t)(((uint64_t)ppm * activeMicroAmps + (uint64_t)(1000000UL - ppm) * sleepMicroAmps) / 1000000UL);
+    }
+
+    /// Prints "wakes":...,"awake_ppm":...,"avg_ua":... to embed in a JSON object.
+    void reportJson(Print& out, uint32_t millis, uint32_t activeMicroAmps, uint32_t sleepMicroAmps) const {
+        out.print(F("\"wakes\":"));
+        out.print((unsigned long)wakes);
+        out.print(F(",\"awake_ppm\":"));
+        out.print((unsigned long)awakePpm(millis));
+        out.print(F(",\"avg_ua\":"));
+        out.print((unsigned long)averageMicroAmps(millis, activeMicroAmps, sleepMicroAmps));
+    }
+};
+
+/// @brief The original single measurement interface, printing microseconds; built on PerfClock.
 class TestPerformance{
 private:
-    char* functionName;
+    const char* functionName;
     bool running;
+    perf_ticks_t start;
 public:
-    TestPerformance(char* functionName){
+    TestPerformance(const char* functionName){
         this->functionName = functionName;
         running = false;
+        start = 0;
     }
     void startCount(){
         if(running){
-            Serial.print("Clock running!\n");
+            Serial.print(F("Clock running!\n"));
             return;
         }
-        TCCR1A = 0;
-        TCCR1B = bit(CS10);
-        TCNT1 = 0;
         running = true;
+        start = PerfClock::now();
     }
     void stopCount(){
+        perf_ticks_t elapsed = PerfClock::now() - start;
         if(!running){
-            Serial.print("Clock is not running!\n");
+            Serial.print(F("Clock is not running!\n"));
             return;
         }
         Serial.print(functionName);
-        Serial.print(" took ");
-        Serial.print((float)(TCNT1 - 1) / 16);
-        Serial.print(" microseconds\n");
+        Serial.print(F(" took "));
+        Serial.print((unsigned long)(PerfClock::toNanos(elapsed) / 1000));
+        Serial.print(F(" microseconds\n"));
         running = false;
     }
 };
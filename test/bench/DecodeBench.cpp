@@ -0,0 +1,158 @@
+//
+// Microbenchmark of the time register decode done by every readTime(): the original field by field decode
+// (divide-free BCDtoDEC per register plus setLow() re-masking of the 12h/PM and century bits) against
+// DS3231::decodeTimeRegisters(). The legacy decode fills the old field by field time struct, decodeTimeRegisters()
+// the packed RTCdata whose date fields are derived on demand.
+//
+// The same code runs on both targets through the harness of test/TestPerformance.h, which prints min, median,
+// p99 and max per decode. On an AVR board, build it as the sketch (e.g. copy it to src/ in place of main.cpp); the
+// report is printed on Serial at 9600 baud. On the host (from the repository root):
+//   g++ -std=c++11 -O2 -Itest/sim -Ilib/DS3231 test/bench/DecodeBench.cpp test/sim/I2CBusSim.cpp test/sim/Wire.cpp test/sim/Print.cpp lib/DS3231/DS3231.cpp -o decode_bench && ./decode_bench
+//
+
+#include <DS3231.h>
+#include "../TestPerformance.h"
+
+// register blocks as the device returns them: 24h, 12h AM/PM, last supported year, end of month
+static const uint8_t BLOCKS[][7] = {
+        {0x59, 0x59, 0x23, 0x07, 0x31, 0x12, 0x88},
+        {0x00, 0x30, 0x72, 0x01, 0x01, 0x01, 0x21},
+        {0x45, 0x07, 0x51, 0x03, 0x15, 0x06, 0x89},
+        {0x12, 0x34, 0x09, 0x05, 0x28, 0x02, 0x24},
+};
+/// a power of two, the host loop picks the blocks with a mask
+static const uint8_t BLOCK_COUNT = sizeof(BLOCKS) / sizeof(BLOCKS[0]);
+
+static uint8_t legacyBCDtoDEC(const uint8_t code) {
+    uint8_t digit1, digit2;
+    digit1 = (code & 0xF0) >> 4;
+    digit2 = (code & 0x0F);
+    return (digit1 * 10 + digit2);
+}
+
+static uint8_t legacySetLow(uint8_t byte, uint8_t bit) {
+    return byte & ~(1 << bit);
+}
+
+// the time struct before RTCdata was packed
+struct LegacyTime{
+    uint8_t seconds;
+    uint8_t minutes;
+    uint8_t hour;
+    dayOfWeek day;
+    uint8_t date;
+    Month month;
+    uint16_t year;
+    bool pm;
+};
+
+// the decode readTime() did before decodeTimeRegisters(); it modifies the block like the original
+static LegacyTime legacyDecode(uint8_t bytes[]) {
+    LegacyTime time;
+    time.seconds = legacyBCDtoDEC(bytes[0]);
+    time.minutes = legacyBCDtoDEC(bytes[1]);
+    time.pm = false;
+    if(bytes[2] >> 6){
+        bytes[2] = legacySetLow(bytes[2], 6);
+        if(bytes[2] >> 5){
+            time.pm = true;
+            bytes[2] = legacySetLow(bytes[2], 5);
+        }
+        time.hour = legacyBCDtoDEC(bytes[2]);
+    }
+    else
+        time.hour = legacyBCDtoDEC(bytes[2]);
+    time.day = dayOfWeek(legacyBCDtoDEC(bytes[3]));
+    time.date = legacyBCDtoDEC(bytes[4]);
+    uint8_t century = 0;
+    if(bytes[5] >> 7 == 1){
+        century = 100;
+        bytes[5] = legacySetLow(bytes[5], 7);
+    }
+    time.month = Month(legacyBCDtoDEC(bytes[5] & 0b00011111));
+    time.year = legacyBCDtoDEC(bytes[6]) + 2000 + century;
+    return time;
+}
+
+// the day of week register is not compared, RTCdata derives it from the date; the hour is compared in 24 hours
+static bool sameTime(const LegacyTime& a, const uint8_t bytes[], const RTCdata& b) {
+    uint8_t hour = a.hour;
+    if(bytes[2] & 0x40) // 12 hour mode
+        hour = hour % 12 + (a.pm ? 12 : 0);
+    return a.seconds == b.seconds() && a.minutes == b.minutes() && hour == b.hour() && a.date == b.date() &&
+           a.month == b.month() && a.year == b.year();
+}
+
+// keeps the decoded values alive
+static volatile uint8_t sink;
+
+static uint8_t fold(const LegacyTime& time) {
+    return time.seconds ^ time.minutes ^ time.hour ^ time.pm ^ time.day ^ time.date ^ time.month ^ time.year;
+}
+
+static uint8_t fold(const RTCdata& time) {
+    return time.packed ^ time.packed >> 8 ^ time.packed >> 16 ^ time.packed >> 24;
+}
+
+#ifdef __AVR__
+/// one decode per sample: Timer1 counts single cycles
+static const uint16_t BATCH = 1;
+static const uint16_t SAMPLES = 256;
+#else
+/// decodes per sample: a single one is shorter than the resolution of the host clock
+static const uint16_t BATCH = 1000;
+static const uint16_t SAMPLES = 10000;
+#endif
+
+static bool runDecodeBench() {
+    PerfClock::begin();
+    for(uint8_t i = 0; i < BLOCK_COUNT; i++){
+        uint8_t copy[7];
+        memcpy(copy, BLOCKS[i], 7);
+        if(!sameTime(legacyDecode(copy), BLOCKS[i], DS3231::decodeTimeRegisters(BLOCKS[i]))){
+            Serial.print(F("block "));
+            Serial.print(i);
+            Serial.println(F(": decodes differ"));
+            return false;
+        }
+    }
+    // the blocks are read through a volatile pointer so the loops cannot be folded
+    const uint8_t (*volatile blocks)[7] = BLOCKS;
+    uint8_t copy[7];
+    uint8_t round = 0;
+
+    PerfRun legacy("legacy decode", BATCH);
+    legacy.measure(SAMPLES, [&]() {
+        for(uint16_t n = 0; n < BATCH; n++){
+            memcpy(copy, blocks[round++ & (BLOCK_COUNT - 1)], 7);
+            sink = fold(legacyDecode(copy));
+        }
+    });
+    PerfRun current("decodeTimeRegisters()", BATCH);
+    current.measure(SAMPLES, [&]() {
+        for(uint16_t n = 0; n < BATCH; n++){
+            memcpy(copy, blocks[round++ & (BLOCK_COUNT - 1)], 7);
+            sink = fold(DS3231::decodeTimeRegisters(copy));
+        }
+    });
+    legacy.report(Serial);
+    current.report(Serial);
+    return true;
+}
+
+#ifdef __AVR__
+
+void setup() {
+    Serial.begin(9600);
+    runDecodeBench();
+}
+
+void loop() {}
+
+#else
+
+int main() {
+    return runDecodeBench() ? 0 : 1;
+}
+
+#endif
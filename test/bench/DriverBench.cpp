@@ -0,0 +1,140 @@
+//
+// Benchmark of the public DS3231 operations: latency and bus cost of each, printed as one JSON object per line so
+// the results of two library versions can be compared by a script.
+//
+//   {"bench":"driver","rev":"unknown","target":"host","bus":"CountingBus<WireBus>","op":"readTime()","n":50,
+//    "min_ns":...,"median_ns":...,"p99_ns":...,"max_ns":...,"mean_ns":...,"tx":50,"bytes_out":50,"bytes_in":...}
+//
+// The latency fields are per call (test/TestPerformance.h). tx (bus transactions), bytes_out and bytes_in are the
+// totals of the n calls, counted by CountingBus. Operations that write the EEPROM are timed up to the end of the
+// write (flushEEPROM()), not only until the write is queued. BENCH_REVISION names the build in the output.
+//
+// The driver must count its bus traffic, so build the library and the benchmark with -DDS3231_STATS=1, or with a
+// counted transport and no method stats (no probe in the timed calls): -DDS3231_BUS='CountingBus<WireBus>'.
+//
+// On an AVR board, build it as the sketch (e.g. copy it to src/ in place of main.cpp); the lines are printed on
+// Serial at 9600 baud. It overwrites the temperature log and the alarms of the board; the time is set back.
+// On the host it runs on the simulated bus and times with the simulated clock (from the repository root):
+//   g++ -std=c++11 -O2 -DDS3231_BUS='CountingBus<WireBus>' -Itest/sim -Ilib/DS3231 test/bench/DriverBench.cpp test/sim/I2CBusSim.cpp test/sim/Wire.cpp test/sim/Print.cpp lib/DS3231/DS3231.cpp -o driver_bench && ./driver_bench
+// Add -DDS3231_BUS='CountingBus<SimBus>' -DDS3231_BUS_HEADER='"SimBus.h"' to bypass the Wire stand-in.
+//
+
+#ifndef __AVR__
+#define PERF_CLOCK_MICROS // simulated time: what the bus takes, not what the host takes
+#endif
+
+#include <DS3231.h>
+#include "../TestPerformance.h"
+
+#ifndef BENCH_REVISION
+#define BENCH_REVISION "unknown"
+#endif
+
+#define BENCH_STRING(text) #text
+#define BENCH_NAME(macro) BENCH_STRING(macro)
+
+// the transport the driver counts through; a compile error here means the traffic is not counted (see above)
+#if DS3231_STATS
+typedef CountingBus<DS3231_BUS> CountedBus;
+#else
+typedef DS3231_BUS CountedBus;
+#endif
+
+#ifdef __AVR__
+static const uint16_t RUNS = 20;
+static const uint16_t EEPROM_RUNS = 5;
+#else
+static const uint16_t RUNS = 50;
+static const uint16_t EEPROM_RUNS = 20;
+#endif
+
+static DS3231 rtc;
+static int16_t temperatures[24];
+static float dummyTemperatures[24];
+
+/// @brief One benchmarked operation.
+struct BenchOperation{
+    const char* name;
+    void (*call)();
+    uint16_t runs;
+};
+
+static const BenchOperation OPERATIONS[] = {
+        {"begin()", []() { rtc.begin(); }, RUNS},
+        {"readTime()", []() { rtc.readTime(); }, RUNS},
+        {"setTime()", []() { rtc.setTime(12, 34, 56); }, RUNS},
+        {"setDate()", []() { rtc.setDate(DAILY, MARCH, 15, 2024); }, RUNS},
+        {"setAlarmDaily()", []() { rtc.setAlarmDaily(1, 6, 30); }, RUNS},
+        {"setAlarmWeekly()", []() { rtc.setAlarmWeekly(2, 7, 45, FRIDAY); }, RUNS},
+        {"toggleAlarm()", []() { rtc.toggleAlarm(1, true); }, RUNS},
+        {"storeAlarmEEPROM()", []() { rtc.storeAlarmEEPROM(1); rtc.flushEEPROM(); }, EEPROM_RUNS},
+        {"readAlarmEEPROM()", []() { rtc.readAlarmEEPROM(1); }, RUNS},
+        // replaces the 24 hours in RAM only, no bus traffic
+        {"writeDummyTemperatures()", []() { rtc.writeDummyTemperatures(dummyTemperatures); }, RUNS},
+        {"readLast24hTemperature()", []() { rtc.readLast24hTemperature(temperatures); }, RUNS},
+};
+
+static void report(Print& out, const char* name, PerfRun& run, const BusTally& cost) {
+    out.print(F("{\"bench\":\"driver\",\"rev\":\""));
+    out.print(BENCH_REVISION);
+#ifdef __AVR__
+    out.print(F("\",\"target\":\"avr\",\"bus\":\""));
+#else
+    out.print(F("\",\"target\":\"host\",\"bus\":\""));
+#endif
+    out.print(BENCH_NAME(DS3231_BUS));
+    out.print(F("\",\"op\":\""));
+    out.print(name);
+    out.print(F("\","));
+    run.reportJson(out);
+    out.print(F(",\"tx\":"));
+    out.print((unsigned long)cost.transactions);
+    out.print(F(",\"bytes_out\":"));
+    out.print((unsigned long)cost.bytesWritten);
+    out.print(F(",\"bytes_in\":"));
+    out.print((unsigned long)cost.bytesRead);
+    out.println(F("}"));
+}
+
+static void runDriverBench() {
+    PerfClock::begin();
+    rtc.begin();
+    for(uint8_t i = 0; i < 24; i++)
+        dummyTemperatures[i] = 20 + i * 0.25f;
+    RTCdata start = rtc.readTime();
+    unsigned long startMillis = millis();
+
+    for(uint8_t i = 0; i < sizeof(OPERATIONS) / sizeof(OPERATIONS[0]); i++){
+        const BenchOperation& operation = OPERATIONS[i];
+        PerfRun run(operation.name);
+        BusTally before = CountedBus::tally();
+        run.measure(operation.runs, operation.call);
+        BusTally after = CountedBus::tally();
+        BusTally cost = {after.transactions - before.transactions, after.bytesWritten - before.bytesWritten,
+                         after.bytesRead - before.bytesRead};
+        report(Serial, operation.name, run, cost);
+    }
+
+    // set the clock back, the time the benchmark took included
+    RTCdata now = RTCdata::fromEpoch(start.epoch() + (millis() - startMillis) / 1000);
+    rtc.setDate(DAILY, now.month(), now.date(), now.year());
+    rtc.setTime(now.hour(), now.minutes(), now.seconds());
+}
+
+#ifdef __AVR__
+
+void setup() {
+    Serial.begin(9600);
+    runDriverBench();
+}
+
+void loop() {}
+
+#else
+
+int main() {
+    runDriverBench();
+    return 0;
+}
+
+#endif
@@ -0,0 +1,153 @@
+//
+// Benchmark of the sleep of the sketch (Scheduler::sleep()): wake up latency, awake time and the average supply
+// current they imply, in idle and in power down mode, printed as one JSON object per mode like DriverBench:
+//
+//   {"bench":"sleep","rev":"unknown","target":"avr","mode":"power_down","seconds":30,"wakes":61,"awake_ppm":...,
+//    "avg_ua":...,"n":30,"min_ns":...,"median_ns":...,"p99_ns":...,"max_ns":...,"mean_ns":...}
+//
+// The 1Hz square wave of the DS3231 wakes the MCU through the pin change interrupt of D2, as in the sketch, and each
+// falling edge runs a task that reads the software clock, the work the clock task of the sketch does every second.
+// The latency samples (n, min_ns, ...) run from the pin change interrupt to the return from sleep(). Powered down, the
+// oscillator start-up comes before the interrupt and is not included (16K clock cycles, 1 ms, with the fuses of an
+// Uno). In idle mode the timer interrupts wake the MCU too (Timer0 every millisecond), which counts as awake time.
+//
+// The MCU cannot measure its supply current. Each mode lasts SLEEP_BENCH_SECONDS, idle mode first, and
+// SLEEP_BENCH_PIN is high while the MCU is awake: read the current of the board with a meter in series, or the awake
+// time with a scope on the pin. avg_ua weights SLEEP_BENCH_ACTIVE_UA and the sleep current of the mode by the
+// measured awake time. The defaults are datasheet values of the ATmega328P alone at 16 MHz and 5 V; set them to the
+// currents measured on the board, whose regulator and LEDs draw more than the MCU.
+//
+// Build it as the sketch (e.g. copy it to src/ in place of main.cpp); the lines are printed on Serial at 9600 baud.
+// There is no host build: the host has nothing to sleep.
+//
+
+#ifndef __AVR__
+#error "the sleep benchmark runs on an AVR board only"
+#endif
+
+#include <DS3231.h>
+#include <Scheduler.h>
+#include "../TestPerformance.h"
+
+#ifndef BENCH_REVISION
+#define BENCH_REVISION "unknown"
+#endif
+
+/// length of each mode
+#ifndef SLEEP_BENCH_SECONDS
+#define SLEEP_BENCH_SECONDS 30
+#endif
+/// high while the MCU is awake (not the LED pin: the LED would be measured)
+#ifndef SLEEP_BENCH_PIN
+#define SLEEP_BENCH_PIN A1
+#endif
+/// supply currents of the MCU in microamps: awake, asleep in idle mode, powered down
+#ifndef SLEEP_BENCH_ACTIVE_UA
+#define SLEEP_BENCH_ACTIVE_UA 9500
+#endif
+#ifndef SLEEP_BENCH_IDLE_UA
+#define SLEEP_BENCH_IDLE_UA 2600
+#endif
+#ifndef SLEEP_BENCH_POWER_DOWN_UA
+#define SLEEP_BENCH_POWER_DOWN_UA 1
+#endif
+
+#define SQW_pin 2
+#define EVENT_SECOND 0x01
+
+static DS3231 rtc;
+static Scheduler scheduler;
+static volatile bool sqwLevel = true;
+/// a falling edge came since the flag was cleared, at wokeAt
+static volatile bool woken = false;
+static volatile perf_ticks_t wokeAt;
+static volatile uint16_t seconds = 0;
+
+ISR(PCINT2_vect) {
+    bool level = digitalRead(SQW_pin);
+    if(sqwLevel && !level){
+        wokeAt = PerfClock::now();
+        woken = true;
+        seconds++;
+        rtc.tick();
+        scheduler.signal(EVENT_SECOND);
+    }
+    sqwLevel = level;
+}
+
+static void clockTaskRun() {
+    rtc.softTime();
+}
+
+static uint16_t secondsCounted() {
+    noInterrupts();
+    uint16_t counted = seconds;
+    interrupts();
+    return counted;
+}
+
+static void report(Print& out, const char* mode, PerfRun& latency, const PerfDuty& duty, uint32_t sleepMicroAmps) {
+    out.print(F("{\"bench\":\"sleep\",\"rev\":\""));
+    out.print(BENCH_REVISION);
+    out.print(F("\",\"target\":\"avr\",\"mode\":\""));
+    out.print(mode);
+    out.print(F("\",\"seconds\":"));
+    out.print((unsigned long)SLEEP_BENCH_SECONDS);
+    out.print(F(","));
+    duty.reportJson(out, SLEEP_BENCH_SECONDS * 1000UL, SLEEP_BENCH_ACTIVE_UA, sleepMicroAmps);
+    out.print(F(","));
+    latency.reportJson(out);
+    out.println(F("}"));
+}
+
+static void runMode(const char* mode, bool powerDown, uint32_t sleepMicroAmps) {
+    PerfRun latency(mode);
+    PerfDuty duty;
+    Serial.flush(); // the UART stops while powered down
+    // start on an edge, so the mode lasts whole seconds
+    uint16_t first = secondsCounted();
+    while(secondsCounted() == first);
+    scheduler.runPending();
+    noInterrupts();
+    seconds = 0;
+    interrupts();
+    duty.awake();
+    while(secondsCounted() < SLEEP_BENCH_SECONDS){
+        scheduler.runPending();
+        woken = false;
+        duty.asleep();
+        digitalWrite(SLEEP_BENCH_PIN, LOW);
+        bool slept = scheduler.sleep(powerDown);
+        digitalWrite(SLEEP_BENCH_PIN, HIGH);
+        perf_ticks_t now = PerfClock::now();
+        duty.awake();
+        // an edge that came before sleep() was called is no wake up: sleep() returned at once
+        if(slept && woken)
+            latency.add(now - wokeAt);
+    }
+    duty.asleep();
+    report(Serial, mode, latency, duty, sleepMicroAmps);
+}
+
+static void runSleepBench() {
+    PerfClock::begin();
+    pinMode(SLEEP_BENCH_PIN, OUTPUT);
+    digitalWrite(SLEEP_BENCH_PIN, HIGH);
+    pinMode(SQW_pin, INPUT);
+    sqwLevel = digitalRead(SQW_pin);
+    *digitalPinToPCMSK(SQW_pin) |= _BV(digitalPinToPCMSKbit(SQW_pin));
+    *digitalPinToPCICR(SQW_pin) |= _BV(digitalPinToPCICRbit(SQW_pin));
+    rtc.begin();
+    rtc.beginSoftClock(60);
+    scheduler.addTask(clockTaskRun, 0, EVENT_SECOND);
+    runMode("idle", false, SLEEP_BENCH_IDLE_UA);
+    runMode("power_down", true, SLEEP_BENCH_POWER_DOWN_UA);
+    rtc.endSoftClock();
+}
+
+void setup() {
+    Serial.begin(9600);
+    runSleepBench();
+}
+
+void loop() {}
@@ -0,0 +1,51 @@
+//
+// Host stand-in for the Arduino core, used to build the DS3231 library on Linux.
+//
+// Only the pieces the library touches are provided. Time is not wall time: millis(),
+// micros() and delay() read and advance the simulated clock owned by I2CBusSim, so
+// every delay(10) in the driver shows up as 10 simulated milliseconds on the bus.
+//
+
+#ifndef DS3231_RTC_SIM_ARDUINO_H
+#define DS3231_RTC_SIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+#include "Print.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+// by value: decltype of the conditional would be a reference to a parameter
+template<typename T, typename U>
+static inline typename std::common_type<T, U>::type min(T a, U b) { return a < b ? a : b; }
+template<typename T, typename U>
+static inline typename std::common_type<T, U>::type max(T a, U b) { return a > b ? a : b; }
+// like the Arduino macro: the type of the value, whatever the bounds are
+template<typename T, typename L, typename H>
+static inline T constrain(T value, L low, H high) { return value < low ? low : value > high ? high : value; }
+
+// the host has a single address space: flash tables are plain arrays
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+
+// the host has no interrupts; square wave edges are delivered synchronously by the simulator
+static inline void noInterrupts() {}
+static inline void interrupts() {}
+
+/// Simulated time since start, in milliseconds.
+unsigned long millis();
+/// Simulated time since start, in microseconds.
+unsigned long micros();
+/// Advances the simulated clock (and the devices on the bus) by ms milliseconds.
+void delay(unsigned long ms);
+/// Advances the simulated clock (and the devices on the bus) by us microseconds.
+void delayMicroseconds(unsigned int us);
+
+#endif //DS3231_RTC_SIM_ARDUINO_H
@@ -0,0 +1,99 @@
+//
+// Reports what the main DS3231 driver calls cost on the simulated bus.
+//
+// Build and run on the host (from the repository root):
+//   g++ -std=c++11 -Itest/sim -Ilib/DS3231 test/sim/*.cpp lib/DS3231/DS3231.cpp -o bus_cost && ./bus_cost
+// Add -DDS3231_STATS=1 to print the driver's own stats table at the end.
+// Add -DDS3231_BUS=SimBus -DDS3231_BUS_HEADER='"SimBus.h"' to bypass the Wire stand-in and its 32 byte buffers.
+//
+
+#include <stdio.h>
+#include <DS3231.h>
+#include "I2CBusSim.h"
+
+static DS3231* softClockRtc = nullptr;
+
+static void squareWaveEdge() {
+    if(softClockRtc)
+        softClockRtc->tick();
+}
+
+static void report(const char* name, const BusStats& cost) {
+    printf("%-34s %5u tx %6u B out %6u B in %3u nack %9llu us bus %9llu us total\n", name,
+           (unsigned)cost.transactions, (unsigned)cost.bytesWritten, (unsigned)cost.bytesRead, (unsigned)cost.nacks,
+           (unsigned long long)cost.busMicros, (unsigned long long)cost.elapsedMicros);
+}
+
+int main() {
+    I2CBusSim& bus = simBus();
+    DS3231 rtc;
+    BusStats before = bus.stats();
+    rtc.begin();
+    report("begin()", bus.stats() - before);
+
+    before = bus.stats();
+    rtc.readTime();
+    report("readTime() (same minute)", bus.stats() - before);
+
+    before = bus.stats();
+    rtc.readSnapshot();
+    report("readSnapshot()", bus.stats() - before);
+
+    // one readTime() per minute until the hourly average is stored in the EEPROM
+    BusStats sample, store;
+    for(uint8_t minute = 1; minute <= 60; minute++) {
+        delay(60000UL);
+        before = bus.stats();
+        rtc.readTime();
+        if(minute == 1)
+            sample = bus.stats() - before;
+        if(minute == 60)
+            store = bus.stats() - before;
+    }
+    report("readTime() (new minute)", sample);
+    report("readTime() (new hour, stores temp)", store);
+
+    before = bus.stats();
+    rtc.readCelcius();
+    report("readCelcius()", bus.stats() - before);
+
+    before = bus.stats();
+    rtc.checkAlarmFlag();
+    report("checkAlarmFlag()", bus.stats() - before);
+
+    before = bus.stats();
+    rtc.toggleAlarm(1, true);
+    report("toggleAlarm()", bus.stats() - before);
+
+    before = bus.stats();
+    rtc.storeAlarmEEPROM(1);
+    report("storeAlarmEEPROM()", bus.stats() - before);
+
+    // a display refreshed every 10 ms for one hour, polling the registers and then driven by the square wave
+    unsigned long end = millis() + 3600000UL;
+    before = bus.stats();
+    while(millis() < end) {
+        rtc.readTime();
+        delay(10);
+    }
+    report("1 h of readTime() every 10 ms", bus.stats() - before);
+
+    softClockRtc = &rtc;
+    bus.rtc.setSquareWaveListener(squareWaveEdge);
+    rtc.beginSoftClock(10);
+    end = millis() + 3600000UL;
+    before = bus.stats();
+    while(millis() < end) {
+        rtc.softTime();
+        delay(10);
+    }
+    report("1 h of softTime() every 10 ms", bus.stats() - before);
+    RTCdata soft = rtc.softTime();
+    RTCdata hard = rtc.readTime();
+    printf("software clock %02u:%02u:%02u, registers %02u:%02u:%02u\n", soft.hour(), soft.minutes(),
+           soft.seconds(), hard.hour(), hard.minutes(), hard.seconds());
+#if DS3231_STATS
+    rtc.dumpStats(Serial);
+#endif
+    return 0;
+}
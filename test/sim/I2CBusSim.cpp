@@ -0,0 +1,472 @@
+//
+// Simulated I2C bus carrying a DS3231 and the AT24C32 EEPROM of the ZS-042 module.
+//
+
+#include "I2CBusSim.h"
+#include "Arduino.h"
+
+#define SIM_DS3231_ADDRESS 0x68
+#define SIM_EEPROM_ADDRESS 0x57
+
+// status register bits that can only be cleared by a write
+#define STATUS_CLEAR_ONLY 0b10000011
+#define STATUS_BSY 0b00000100
+#define STATUS_WRITABLE 0b00001000
+#define CONTROL_CONV 0b00100000
+
+#define CONVERSION_PERIOD 64 // seconds between automatic conversions
+#define CONVERSION_TIME 125000 // microseconds
+
+BusStats BusStats::operator - (const BusStats& other) const {
+    BusStats diff;
+    diff.transactions = transactions - other.transactions;
+    diff.bytesWritten = bytesWritten - other.bytesWritten;
+    diff.bytesRead = bytesRead - other.bytesRead;
+    diff.nacks = nacks - other.nacks;
+    diff.busMicros = busMicros - other.busMicros;
+    diff.elapsedMicros = elapsedMicros - other.elapsedMicros;
+    return diff;
+}
+
+static uint8_t toBCD(uint8_t dec) {
+    return (uint8_t)(((dec / 10) << 4) | (dec % 10));
+}
+
+static uint8_t fromBCD(uint8_t bcd) {
+    return (uint8_t)((bcd >> 4) * 10 + (bcd & 0x0F));
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                                 DS3231
+---------------------------------------------------------------------------------------------------------------------*/
+
+DS3231Model::DS3231Model() {
+    squareWaveListener = nullptr;
+    reset();
+}
+
+void DS3231Model::reset() {
+    memset(regs, 0, sizeof(regs));
+    regs[0x03] = 0x06; // Saturday
+    regs[0x04] = 0x01;
+    regs[0x05] = 0x01;
+    regs[0x0E] = 0b00011100; // RS2, RS1, INTCN
+    regs[0x0F] = 0b10001000; // OSF, EN32kHz
+    pointer = 0;
+    subSecond = 0;
+    secondsToConversion = CONVERSION_PERIOD;
+    conversionRemaining = 0;
+    setTemperature(25 * 4);
+    regs[0x11] = (uint8_t)(temperature >> 2);
+    regs[0x12] = (uint8_t)((temperature & 0x03) << 6);
+}
+
+uint8_t DS3231Model::peek(uint8_t reg) const {
+    return regs[reg % REGISTERS];
+}
+
+void DS3231Model::poke(uint8_t reg, uint8_t value) {
+    regs[reg % REGISTERS] = value;
+}
+
+void DS3231Model::setTemperature(int16_t quarterDegrees) {
+    temperature = quarterDegrees;
+}
+
+bool DS3231Model::intAsserted() const {
+    if(!(regs[0x0E] & 0b00000100)) // INTCN = 0 -> square wave, not an alarm interrupt
+        return false;
+    bool a1 = (regs[0x0E] & 0x01) && (regs[0x0F] & 0x01);
+    bool a2 = (regs[0x0E] & 0x02) && (regs[0x0F] & 0x02);
+    return a1 || a2;
+}
+
+void DS3231Model::setSquareWaveListener(void (*listener)()) {
+    squareWaveListener = listener;
+}
+
+void DS3231Model::setPointer(uint8_t reg) {
+    pointer = reg % REGISTERS;
+}
+
+void DS3231Model::writeByte(uint8_t value) {
+    switch (pointer) {
+        case 0x00:
+            regs[0x00] = value & 0x7F;
+            subSecond = 0; // writing the seconds register resets the countdown chain
+            break;
+        case 0x0E:
+            regs[0x0E] = value & ~CONTROL_CONV;
+            if(value & CONTROL_CONV)
+                startConversion();
+            break;
+        case 0x0F:
+            regs[0x0F] = (regs[0x0F] & STATUS_BSY) | (regs[0x0F] & value & STATUS_CLEAR_ONLY) | (value & STATUS_WRITABLE);
+            break;
+        case 0x11:
+        case 0x12:
+            break; // temperature registers are read-only
+        default:
+            regs[pointer] = value;
+    }
+    // the address pointer wraps from 0x12 back to 0x00
+    pointer = (pointer + 1) % REGISTERS;
+}
+
+uint8_t DS3231Model::readByte() {
+    uint8_t value = regs[pointer];
+    if(pointer == 0x0E && conversionRemaining)
+        value |= CONTROL_CONV;
+    pointer = (pointer + 1) % REGISTERS;
+    return value;
+}
+
+void DS3231Model::startConversion() {
+    if(conversionRemaining)
+        return;
+    conversionRemaining = CONVERSION_TIME;
+    regs[0x0F] |= STATUS_BSY;
+}
+
+void DS3231Model::advance(uint64_t micros) {
+    while(micros > 0) {
+        uint32_t toSecond = 1000000 - subSecond;
+        uint32_t step = micros < toSecond ? (uint32_t)micros : toSecond;
+        if(conversionRemaining && step >= conversionRemaining) {
+            step = conversionRemaining;
+        }
+        micros -= step;
+        subSecond += step;
+        if(conversionRemaining) {
+            conversionRemaining -= step;
+            if(conversionRemaining == 0) {
+                regs[0x0F] &= ~STATUS_BSY;
+                regs[0x11] = (uint8_t)(temperature >> 2);
+                regs[0x12] = (uint8_t)((temperature & 0x03) << 6);
+            }
+        }
+        if(subSecond == 1000000) {
+            subSecond = 0;
+            if(regs[0x0E] & 0x80) // EOSC set: the oscillator stops (only on VBAT in reality)
+                continue;
+            tickSecond();
+            checkAlarms();
+            if(--secondsToConversion == 0) {
+                secondsToConversion = CONVERSION_PERIOD;
+                startConversion();
+            }
+            if(squareWaveListener && !(regs[0x0E] & 0b00011100))
+                squareWaveListener();
+        }
+    }
+}
+
+void DS3231Model::tickSecond() {
+    uint8_t seconds = fromBCD(regs[0x00]) + 1;
+    if(seconds < 60) {
+        regs[0x00] = toBCD(seconds);
+        return;
+    }
+    regs[0x00] = 0;
+    uint8_t minutes = fromBCD(regs[0x01]) + 1;
+    if(minutes < 60) {
+        regs[0x01] = toBCD(minutes);
+        return;
+    }
+    regs[0x01] = 0;
+    uint8_t hourReg = regs[0x02];
+    if(hourReg & 0x40) { // 12 hour mode, bit 5 is AM/PM
+        bool pm = hourReg & 0x20;
+        uint8_t hour = fromBCD(hourReg & 0x1F) + 1;
+        if(hour == 12)
+            pm = !pm;
+        if(hour == 13)
+            hour = 1;
+        regs[0x02] = 0x40 | (pm ? 0x20 : 0) | toBCD(hour);
+        if(!(hour == 12 && !pm)) // the date only changes at 12 AM
+            return;
+    }
+    else {
+        uint8_t hour = fromBCD(hourReg & 0x3F) + 1;
+        if(hour < 24) {
+            regs[0x02] = toBCD(hour);
+            return;
+        }
+        regs[0x02] = 0;
+    }
+    regs[0x03] = regs[0x03] % 7 + 1;
+    static const uint8_t monthDays[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+    uint8_t year = fromBCD(regs[0x06]);
+    uint8_t month = fromBCD(regs[0x05] & 0x1F);
+    uint8_t date = fromBCD(regs[0x04]) + 1;
+    uint8_t days = monthDays[(month - 1) % 12];
+    if(month == 2 && year % 4 == 0) // the chip's leap year rule, valid from 2000 to 2099
+        days = 29;
+    if(date <= days) {
+        regs[0x04] = toBCD(date);
+        return;
+    }
+    regs[0x04] = 0x01;
+    uint8_t century = regs[0x05] & 0x80;
+    month++;
+    if(month <= 12) {
+        regs[0x05] = century | toBCD(month);
+        return;
+    }
+    year++;
+    if(year == 100) { // the century bit toggles when the years register overflows
+        year = 0;
+        century ^= 0x80;
+    }
+    regs[0x05] = century | 0x01;
+    regs[0x06] = toBCD(year);
+}
+
+void DS3231Model::checkAlarms() {
+    // alarm 1: A1M1..A1M4 select which of seconds, minutes, hours and day/date must match
+    bool match = true;
+    if(!(regs[0x07] & 0x80))
+        match &= (regs[0x07] & 0x7F) == regs[0x00];
+    if(!(regs[0x08] & 0x80))
+        match &= (regs[0x08] & 0x7F) == regs[0x01];
+    if(!(regs[0x09] & 0x80))
+        match &= (regs[0x09] & 0x7F) == (regs[0x02] & 0x7F);
+    if(!(regs[0x0A] & 0x80)) {
+        if(regs[0x0A] & 0x40)
+            match &= (regs[0x0A] & 0x0F) == (regs[0x03] & 0x07);
+        else
+            match &= (regs[0x0A] & 0x3F) == (regs[0x04] & 0x3F);
+    }
+    if(match)
+        regs[0x0F] |= 0x01;
+    // alarm 2 has no seconds register and is only evaluated at 00 seconds
+    if(regs[0x00] != 0)
+        return;
+    match = true;
+    if(!(regs[0x0B] & 0x80))
+        match &= (regs[0x0B] & 0x7F) == regs[0x01];
+    if(!(regs[0x0C] & 0x80))
+        match &= (regs[0x0C] & 0x7F) == (regs[0x02] & 0x7F);
+    if(!(regs[0x0D] & 0x80)) {
+        if(regs[0x0D] & 0x40)
+            match &= (regs[0x0D] & 0x0F) == (regs[0x03] & 0x07);
+        else
+            match &= (regs[0x0D] & 0x3F) == (regs[0x04] & 0x3F);
+    }
+    if(match)
+        regs[0x0F] |= 0x02;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                                 AT24C32
+---------------------------------------------------------------------------------------------------------------------*/
+
+AT24C32Model::AT24C32Model() {
+    writeCycle = 5000;
+    reset();
+}
+
+void AT24C32Model::reset() {
+    memset(memory, 0xFF, sizeof(memory));
+    memset(writes, 0, sizeof(writes));
+    memset(latched, 0, sizeof(latched));
+    pointer = 0;
+    addressBytes = 0;
+    latchedCount = 0;
+    busyRemaining = 0;
+}
+
+uint8_t AT24C32Model::peek(uint16_t address) const {
+    return memory[address % SIZE];
+}
+
+void AT24C32Model::poke(uint16_t address, uint8_t value) {
+    memory[address % SIZE] = value;
+}
+
+uint32_t AT24C32Model::pageWrites(uint16_t page) const {
+    return writes[page % PAGES];
+}
+
+void AT24C32Model::setWriteCycle(uint32_t micros) {
+    writeCycle = micros;
+}
+
+bool AT24C32Model::busy() const {
+    return busyRemaining > 0;
+}
+
+void AT24C32Model::beginWrite() {
+    addressBytes = 0;
+    latchedCount = 0;
+    memset(latched, 0, sizeof(latched));
+}
+
+void AT24C32Model::writeByte(uint8_t value) {
+    if(addressBytes == 0) {
+        pointer = (uint16_t)((value << 8) | (pointer & 0xFF)) % SIZE; // A12..A15 are don't care
+        addressBytes++;
+        return;
+    }
+    if(addressBytes == 1) {
+        pointer = (pointer & 0xFF00) | value;
+        addressBytes++;
+        return;
+    }
+    // data bytes are latched in the page buffer; the address rolls over inside the page
+    uint8_t offset = pointer % PAGE_SIZE;
+    latch[offset] = value;
+    latched[offset] = true;
+    latchedCount++;
+    pointer = (pointer & ~(uint16_t)(PAGE_SIZE - 1)) | ((offset + 1) % PAGE_SIZE);
+}
+
+void AT24C32Model::endWrite(bool stop) {
+    if(!stop || latchedCount == 0)
+        return; // address only (random read setup) or no STOP -> nothing is programmed
+    uint16_t page = pointer & ~(uint16_t)(PAGE_SIZE - 1);
+    for(uint8_t i = 0; i < PAGE_SIZE; i++) {
+        if(latched[i])
+            memory[page + i] = latch[i];
+    }
+    writes[page / PAGE_SIZE]++;
+    latchedCount = 0;
+    memset(latched, 0, sizeof(latched));
+    busyRemaining = writeCycle;
+}
+
+uint8_t AT24C32Model::readByte() {
+    uint8_t value = memory[pointer];
+    pointer = (pointer + 1) % SIZE;
+    return value;
+}
+
+void AT24C32Model::advance(uint64_t micros) {
+    if(micros >= busyRemaining)
+        busyRemaining = 0;
+    else
+        busyRemaining -= (uint32_t)micros;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                                 BUS
+---------------------------------------------------------------------------------------------------------------------*/
+
+I2CBusSim::I2CBusSim() {
+    clockHz = 100000;
+    reset();
+}
+
+void I2CBusSim::reset() {
+    rtc.reset();
+    eeprom.reset();
+    nowMicros = 0;
+    fraction = 0;
+    open = false;
+    resetStats();
+}
+
+void I2CBusSim::setClock(uint32_t hz) {
+    clockHz = hz;
+}
+
+void I2CBusSim::clockBits(uint32_t bits) {
+    // keeps the remainder so that many short transactions add up exactly
+    fraction += (uint64_t)bits * 1000000;
+    uint64_t micros = fraction / clockHz;
+    fraction %= clockHz;
+    counters.busMicros += micros;
+    advance(micros);
+}
+
+uint8_t I2CBusSim::transmit(uint8_t address, const uint8_t data[], uint8_t length, bool stop) {
+    if(!open)
+        counters.transactions++;
+    open = !stop;
+    bool acked = (address == SIM_DS3231_ADDRESS) || (address == SIM_EEPROM_ADDRESS && !eeprom.busy());
+    if(!acked) {
+        open = false; // the master sends STOP after a NACK
+        counters.nacks++;
+        clockBits(1 + 9 + 1); // START, address + NACK, STOP
+        return 2;
+    }
+    if(address == SIM_DS3231_ADDRESS) {
+        for(uint8_t i = 0; i < length; i++) {
+            if(i == 0)
+                rtc.setPointer(data[0]);
+            else
+                rtc.writeByte(data[i]);
+        }
+    }
+    else {
+        eeprom.beginWrite();
+        for(uint8_t i = 0; i < length; i++)
+            eeprom.writeByte(data[i]);
+    }
+    counters.bytesWritten += length;
+    clockBits(1 + 9 * (1 + length) + (stop ? 1 : 0));
+    if(address == SIM_EEPROM_ADDRESS)
+        eeprom.endWrite(stop);
+    return 0;
+}
+
+uint8_t I2CBusSim::receive(uint8_t address, uint8_t data[], uint8_t length) {
+    if(!open)
+        counters.transactions++;
+    open = false;
+    bool acked = (address == SIM_DS3231_ADDRESS) || (address == SIM_EEPROM_ADDRESS && !eeprom.busy());
+    if(!acked) {
+        counters.nacks++;
+        clockBits(1 + 9 + 1);
+        return 0;
+    }
+    for(uint8_t i = 0; i < length; i++)
+        data[i] = address == SIM_DS3231_ADDRESS ? rtc.readByte() : eeprom.readByte();
+    counters.bytesRead += length;
+    clockBits(1 + 9 * (1 + length) + 1);
+    return length;
+}
+
+void I2CBusSim::advance(uint64_t micros) {
+    nowMicros += micros;
+    counters.elapsedMicros += micros;
+    rtc.advance(micros);
+    eeprom.advance(micros);
+}
+
+uint64_t I2CBusSim::now() const {
+    return nowMicros;
+}
+
+const BusStats& I2CBusSim::stats() const {
+    return counters;
+}
+
+void I2CBusSim::resetStats() {
+    memset(&counters, 0, sizeof(counters));
+}
+
+I2CBusSim& simBus() {
+    static I2CBusSim bus;
+    return bus;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+ *                                          ARDUINO TIME FUNCTIONS
+---------------------------------------------------------------------------------------------------------------------*/
+
+unsigned long millis() {
+    return (unsigned long)(simBus().now() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)simBus().now();
+}
+
+void delay(unsigned long ms) {
+    simBus().advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    simBus().advance(us);
+}
@@ -0,0 +1,151 @@
+//
+// Simulated I2C bus carrying a DS3231 and the AT24C32 EEPROM of the ZS-042 module.
+//
+// The models follow the datasheets closely enough to exercise the driver: the DS3231
+// register file (0x00 - 0x12) keeps time in BCD with 12/24 hour modes, month/leap-year
+// rollover and the century bit, raises A1F/A2F on alarm matches, runs the 64 s temperature
+// conversion (BSY) and only lets A1F/A2F/OSF be cleared. The EEPROM has 4 KB of storage
+// behind a 12 bit address, 32 byte pages that wrap on page writes and a write cycle
+// during which the chip does not acknowledge its address.
+//
+// Every transaction is counted and costs bus time at the configured SCL frequency, so the
+// price of a driver call can be read back as transactions, bytes and simulated microseconds.
+//
+
+#ifndef DS3231_RTC_I2CBUSSIM_H
+#define DS3231_RTC_I2CBUSSIM_H
+
+#include <stdint.h>
+
+/// @brief Counters accumulated by the simulated bus.
+struct BusStats{
+    /// START ... STOP sequences; a repeated START does not open a new transaction
+    uint32_t transactions;
+    /// data bytes sent by the master, register/memory address bytes included
+    uint32_t bytesWritten;
+    /// data bytes clocked out of a device
+    uint32_t bytesRead;
+    /// address phases that were not acknowledged
+    uint32_t nacks;
+    /// time spent clocking the bus
+    uint64_t busMicros;
+    /// total simulated time, bus time plus every delay()
+    uint64_t elapsedMicros;
+    BusStats operator - (const BusStats& other) const;
+};
+
+/// @brief Register level model of the DS3231.
+class DS3231Model{
+public:
+    static const uint8_t REGISTERS = 0x13;
+    DS3231Model();
+    /// Power-on state: 00:00:00 Saturday 01/01/2000, INTCN set, OSF set, 25.00 C.
+    void reset();
+    /// Reads a register without going through the bus.
+    uint8_t peek(uint8_t reg) const;
+    /// Writes a register without going through the bus and without the write filters.
+    void poke(uint8_t reg, uint8_t value);
+    /// Value the next temperature conversion will latch, in 0.25 C steps.
+    void setTemperature(int16_t quarterDegrees);
+    /// State of the active-low INT/SQW line as an interrupt source (true -> line is low).
+    bool intAsserted() const;
+    /// Called on every 1 Hz square wave edge while INTCN = 0 and RS2 = RS1 = 0.
+    void setSquareWaveListener(void (*listener)());
+
+    // bus side
+    void setPointer(uint8_t reg);
+    void writeByte(uint8_t value);
+    uint8_t readByte();
+    void advance(uint64_t micros);
+private:
+    void tickSecond();
+    void checkAlarms();
+    void startConversion();
+    uint8_t regs[REGISTERS];
+    uint8_t pointer;
+    int16_t temperature;
+    uint32_t subSecond;
+    uint8_t secondsToConversion;
+    uint32_t conversionRemaining;
+    void (*squareWaveListener)();
+};
+
+/// @brief Model of the AT24C32 serial EEPROM.
+class AT24C32Model{
+public:
+    static const uint16_t SIZE = 4096;
+    static const uint8_t PAGE_SIZE = 32;
+    static const uint16_t PAGES = SIZE / PAGE_SIZE;
+    AT24C32Model();
+    /// Erases the memory (all 0xFF) and clears the wear counters.
+    void reset();
+    uint8_t peek(uint16_t address) const;
+    void poke(uint16_t address, uint8_t value);
+    /// Number of write cycles each page went through since the last reset.
+    uint32_t pageWrites(uint16_t page) const;
+    /// Self-timed write cycle length, 5 ms by default.
+    void setWriteCycle(uint32_t micros);
+    /// True while a write cycle is running and the chip ignores its address.
+    bool busy() const;
+
+    // bus side
+    void beginWrite();
+    void writeByte(uint8_t value);
+    void endWrite(bool stop);
+    uint8_t readByte();
+    void advance(uint64_t micros);
+private:
+    uint8_t memory[SIZE];
+    uint32_t writes[PAGES];
+    uint16_t pointer;
+    uint8_t addressBytes;
+    uint8_t latch[PAGE_SIZE];
+    bool latched[PAGE_SIZE];
+    uint8_t latchedCount;
+    uint32_t writeCycle;
+    uint32_t busyRemaining;
+};
+
+/**
+ * @brief The simulated bus and its simulated clock.
+ *
+ * Devices answer at their fixed addresses (0x68 for the DS3231, 0x57 for the EEPROM);
+ * any other address is not acknowledged.
+ */
+class I2CBusSim{
+public:
+    DS3231Model rtc;
+    AT24C32Model eeprom;
+    I2CBusSim();
+    /// Resets both devices, the clock and the counters.
+    void reset();
+    /// SCL frequency used to cost transactions, 100 kHz by default.
+    void setClock(uint32_t hz);
+    /**
+     * Master write transaction.
+     * @return Wire status: 0 -> ACK; 2 -> NACK on address
+     */
+    uint8_t transmit(uint8_t address, const uint8_t data[], uint8_t length, bool stop);
+    /**
+     * Master read transaction.
+     * @return Number of bytes read, 0 if the address was not acknowledged
+     */
+    uint8_t receive(uint8_t address, uint8_t data[], uint8_t length);
+    /// Moves simulated time forward without bus activity.
+    void advance(uint64_t micros);
+    uint64_t now() const;
+    const BusStats& stats() const;
+    void resetStats();
+private:
+    void clockBits(uint32_t bits);
+    uint32_t clockHz;
+    uint64_t nowMicros;
+    uint64_t fraction;
+    bool open;
+    BusStats counters;
+};
+
+/// The bus the host Wire object talks to.
+I2CBusSim& simBus();
+
+#endif //DS3231_RTC_I2CBUSSIM_H
@@ -0,0 +1,63 @@
+//
+// Host stand-in for the Arduino Print class and the Serial object.
+//
+
+#include "Print.h"
+#include <stdio.h>
+
+size_t Print::write(const char* text) {
+    size_t written = 0;
+    while(*text)
+        written += write((uint8_t)*text++);
+    return written;
+}
+
+size_t Print::print(const char* text) {
+    return write(text);
+}
+
+size_t Print::print(char character) {
+    return write((uint8_t)character);
+}
+
+size_t Print::print(unsigned long number, int base) {
+    char digits[8 * sizeof(unsigned long) + 1];
+    char* digit = &digits[sizeof(digits) - 1];
+    *digit = '\0';
+    if(base < 2)
+        base = DEC;
+    do{
+        unsigned long remainder = number % base;
+        number /= base;
+        *--digit = remainder < 10 ? '0' + remainder : 'A' + remainder - 10;
+    } while(number);
+    return write(digit);
+}
+
+size_t Print::print(long number, int base) {
+    if(base == DEC && number < 0)
+        return print('-') + print(0UL - (unsigned long)number, DEC);
+    return print((unsigned long)number, base);
+}
+
+size_t Print::println() {
+    return write("\r\n");
+}
+
+size_t Print::println(const char* text) {
+    return print(text) + println();
+}
+
+size_t Print::println(unsigned long number, int base) {
+    return print(number, base) + println();
+}
+
+size_t Print::println(long number, int base) {
+    return print(number, base) + println();
+}
+
+size_t HostSerial::write(uint8_t data) {
+    return putchar(data) == EOF ? 0 : 1;
+}
+
+HostSerial Serial;
@@ -0,0 +1,49 @@
+//
+// Host stand-in for the Arduino Print class and the Serial object.
+//
+// Print keeps the AVR core's interface for the calls the library and the benchmarks make; Serial writes to
+// stdout. Strings in flash are plain strings on the host, so F() is a no-op.
+//
+
+#ifndef DS3231_RTC_SIM_PRINT_H
+#define DS3231_RTC_SIM_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define DEC 10
+#define HEX 16
+
+#define F(string) (string)
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t data) = 0;
+    size_t write(const char* text);
+    size_t print(const char* text);
+    size_t print(char character);
+    size_t print(unsigned long number, int base = DEC);
+    size_t print(long number, int base = DEC);
+    size_t print(unsigned int number, int base = DEC) { return print((unsigned long)number, base); }
+    size_t print(int number, int base = DEC) { return print((long)number, base); }
+    size_t print(unsigned char number, int base = DEC) { return print((unsigned long)number, base); }
+    size_t println();
+    size_t println(const char* text);
+    size_t println(unsigned long number, int base = DEC);
+    size_t println(long number, int base = DEC);
+    size_t println(unsigned int number, int base = DEC) { return println((unsigned long)number, base); }
+    size_t println(int number, int base = DEC) { return println((long)number, base); }
+};
+
+/// @brief Serial port of the host: everything printed goes to stdout.
+class HostSerial : public Print {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t data) override;
+    using Print::write;
+};
+
+extern HostSerial Serial;
+
+#endif //DS3231_RTC_SIM_PRINT_H
@@ -0,0 +1,67 @@
+//
+// Bus transport test double: hands every transaction straight to the simulated bus (I2CBusSim), without the
+// Wire stand-in and its 32 byte buffers. Selected at build time, for example:
+//   g++ -std=c++11 -DDS3231_BUS=SimBus -DDS3231_BUS_HEADER='"SimBus.h"' -Itest/sim -Ilib/DS3231 ...
+//
+// It also counts the calls the driver makes, so a host test can check which transactions a method caused.
+//
+
+#ifndef DS3231_RTC_SIM_SIMBUS_H
+#define DS3231_RTC_SIM_SIMBUS_H
+
+#include "Arduino.h"
+#include "I2CBusSim.h"
+
+/// @brief Calls made through SimBus since the last reset.
+struct SimBusCalls{
+    uint32_t writes;
+    uint32_t reads;
+    /// endWrite() and read() results other than success
+    uint32_t failures;
+};
+
+struct SimBus{
+    static const uint8_t MAX_TRANSFER = 255;
+
+    static void begin() {}
+    static void beginWrite(uint8_t address) {
+        state().address = address;
+        state().length = 0;
+    }
+    static void write(uint8_t data) {
+        if(state().length < MAX_TRANSFER)
+            state().buffer[state().length++] = data;
+    }
+    static uint8_t endWrite(bool stop) {
+        calls().writes++;
+        uint8_t status = simBus().transmit(state().address, state().buffer, state().length, stop);
+        if(status)
+            calls().failures++;
+        return status;
+    }
+    static uint8_t read(uint8_t address, uint8_t buffer[], uint8_t length) {
+        calls().reads++;
+        uint8_t received = simBus().receive(address, buffer, length);
+        if(received != length)
+            calls().failures++;
+        return received;
+    }
+
+    static SimBusCalls& calls() {
+        static SimBusCalls counters = {0, 0, 0};
+        return counters;
+    }
+
+private:
+    struct State{
+        uint8_t address;
+        uint8_t length;
+        uint8_t buffer[MAX_TRANSFER];
+    };
+    static State& state() {
+        static State pending;
+        return pending;
+    }
+};
+
+#endif //DS3231_RTC_SIM_SIMBUS_H
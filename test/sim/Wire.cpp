@@ -0,0 +1,77 @@
+//
+// Host stand-in for the Arduino Wire library.
+//
+
+#include "Wire.h"
+#include "I2CBusSim.h"
+
+TwoWire::TwoWire() {
+    txAddress = 0;
+    txLength = 0;
+    transmitting = false;
+    rxIndex = 0;
+    rxLength = 0;
+}
+
+void TwoWire::begin() {
+    rxIndex = 0;
+    rxLength = 0;
+    txLength = 0;
+}
+
+void TwoWire::setClock(uint32_t frequency) {
+    simBus().setClock(frequency);
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    txAddress = address;
+    txLength = 0;
+    transmitting = true;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    transmitting = false;
+    return simBus().transmit(txAddress, txBuffer, txLength, sendStop);
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop) {
+    (void)sendStop;
+    // like the AVR core, a request larger than the buffer is silently clamped
+    if(quantity > BUFFER_LENGTH)
+        quantity = BUFFER_LENGTH;
+    rxLength = simBus().receive(address, rxBuffer, quantity);
+    rxIndex = 0;
+    return rxLength;
+}
+
+size_t TwoWire::write(uint8_t data) {
+    if(!transmitting || txLength >= BUFFER_LENGTH)
+        return 0;
+    txBuffer[txLength++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+    size_t written = 0;
+    for(size_t i = 0; i < quantity; i++)
+        written += write(data[i]);
+    return written;
+}
+
+int TwoWire::available() {
+    return rxLength - rxIndex;
+}
+
+int TwoWire::read() {
+    if(rxIndex >= rxLength)
+        return -1;
+    return rxBuffer[rxIndex++];
+}
+
+int TwoWire::peek() {
+    if(rxIndex >= rxLength)
+        return -1;
+    return rxBuffer[rxIndex];
+}
+
+TwoWire Wire;
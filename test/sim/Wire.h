@@ -0,0 +1,51 @@
+//
+// Host stand-in for the Arduino Wire library.
+//
+// Mirrors the AVR TwoWire interface and its 32 byte transmit/receive buffers, but every
+// transaction is delivered to the simulated bus (I2CBusSim) instead of the TWI hardware.
+//
+
+#ifndef DS3231_RTC_SIM_WIRE_H
+#define DS3231_RTC_SIM_WIRE_H
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+private:
+    uint8_t txAddress;
+    uint8_t txBuffer[BUFFER_LENGTH];
+    uint8_t txLength;
+    bool transmitting;
+    uint8_t rxBuffer[BUFFER_LENGTH];
+    uint8_t rxIndex;
+    uint8_t rxLength;
+public:
+    TwoWire();
+    void begin();
+    void setClock(uint32_t frequency);
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    /**
+     * Sends the buffered bytes to the simulated bus.
+     * @return 0 -> success; 1 -> data too long; 2 -> NACK on address; 3 -> NACK on data
+     */
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = true);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)true); }
+    uint8_t requestFrom(int address, int quantity, int sendStop) { return requestFrom((uint8_t)address, (uint8_t)quantity, (uint8_t)sendStop); }
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t quantity);
+    size_t write(unsigned long n) { return write((uint8_t)n); }
+    size_t write(long n) { return write((uint8_t)n); }
+    size_t write(unsigned int n) { return write((uint8_t)n); }
+    size_t write(int n) { return write((uint8_t)n); }
+    int available();
+    int read();
+    int peek();
+};
+
+extern TwoWire Wire;
+
+#endif //DS3231_RTC_SIM_WIRE_H